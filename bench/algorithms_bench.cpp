@@ -0,0 +1,138 @@
+// The generic algorithms of lib/graphs over the CSR graph and over a hashed DirectedGraph. The
+// Map runs the CSR ones with a reused workspace.
+//
+//   bench_algorithms [side] [queries]
+//
+// Prints the time per point to point query and whether the distances, hop counts and component
+// counts agree.
+
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "CompactGraph.h"
+#include "DirectedGraph.h"
+#include "algorithms.h"
+#include "bench.h"
+
+using namespace citymap;
+
+using Vertex = CompactGraph::Vertex;
+
+int main(int argc, char* argv[]) {
+    std::size_t side    = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200;
+    std::size_t queries = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100;
+
+    Map map;
+    bench::makeCity(map, side);
+    CompactGraph compact(map, VertexOrder::Hilbert);
+    graphs::DirectedGraph<PointId> hashed;
+    for (auto id : map.ids())
+        hashed.insertVertex(id);
+    for (auto id : map.ids())
+        for (auto to : map.connectionsOf(id))
+            hashed.addEdge(id, to);
+    std::cout << "city: " << compact.size() << " points, " << compact.edgeCount()
+              << " connections, " << queries << " queries\n";
+
+    std::mt19937_64 rng(11);
+    std::uniform_int_distribution<PointId> pick(0, map.size() - 1);
+    std::vector<std::pair<PointId, PointId>> pairs(queries);
+    for (auto& pair : pairs)
+        pair = {pick(rng), pick(rng)};
+
+    auto compactWeight = [&compact](Vertex u, Vertex v) {
+        return metrics::manhattan(compact.point(u), compact.point(v));
+    };
+    auto hashedWeight = [&map](PointId u, PointId v) {
+        return metrics::manhattan(map.valueOf(u), map.valueOf(v));
+    };
+
+    std::vector<double> expected;
+    graphs::SearchTree<CompactGraph, double> tree;
+    auto begin = bench::Clock::now();
+    for (auto [from, to] : pairs) {
+        auto target = compact.vertexOf(to);
+        graphs::dijkstra(compact, compact.vertexOf(from), compact.weight(metrics::manhattan),
+                         target, tree);
+        expected.push_back(tree.distance(target));
+    }
+    double csrWeightMs = bench::millisecondsSince(begin);
+
+    // time of running query(i) for every pair, and whether it always returned expected[i]
+    auto measure = [&](auto query) {
+        bool exact = true;
+        auto begin = bench::Clock::now();
+        for (std::size_t i = 0; i < pairs.size(); i++) {
+            double distance  = query(pairs[i].first, pairs[i].second);
+            bool unreachable = std::isinf(distance) && std::isinf(expected[i]);
+            exact            = exact && (distance == expected[i] || unreachable);
+        }
+        return std::pair(bench::millisecondsSince(begin), exact);
+    };
+
+    auto compactDijkstra = measure([&](PointId from, PointId to) {
+        auto target = compact.vertexOf(to);
+        return graphs::dijkstra(compact, compact.vertexOf(from), compactWeight, target)
+            .distance(target);
+    });
+    auto reusedDijkstra = measure([&](PointId from, PointId to) {
+        auto target = compact.vertexOf(to);
+        graphs::dijkstra(compact, compact.vertexOf(from), compactWeight, target, tree);
+        return tree.distance(target);
+    });
+    auto compactAstar = measure([&](PointId from, PointId to) {
+        auto target = compact.vertexOf(to);
+        auto goal   = compact.point(target);
+        graphs::astar(compact, compact.vertexOf(from), target, compactWeight,
+                      [&](Vertex v) { return metrics::manhattan(compact.point(v), goal); }, tree);
+        return tree.distance(target);
+    });
+    auto hashedDijkstra = measure([&](PointId from, PointId to) {
+        return graphs::dijkstra(hashed, from, hashedWeight, to).distance(to);
+    });
+
+    bool hopsAgree = true;
+    begin          = bench::Clock::now();
+    std::vector<std::size_t> hops;
+    for (auto [from, to] : pairs) {
+        auto target = compact.vertexOf(to);
+        hops.push_back(graphs::bfs(compact, compact.vertexOf(from), target).distance(target));
+    }
+    double compactBfsMs = bench::millisecondsSince(begin);
+    begin               = bench::Clock::now();
+    for (std::size_t i = 0; i < pairs.size(); i++) {
+        auto [from, to] = pairs[i];
+        hopsAgree       = hopsAgree && graphs::bfs(hashed, from, to).distance(to) == hops[i];
+    }
+    double hashedBfsMs = bench::millisecondsSince(begin);
+
+    begin                = bench::Clock::now();
+    auto compactScc      = graphs::stronglyConnectedComponents(compact);
+    double compactSccMs  = bench::millisecondsSince(begin);
+    begin                = bench::Clock::now();
+    auto hashedScc       = graphs::stronglyConnectedComponents(hashed);
+    double hashedSccMs   = bench::millisecondsSince(begin);
+    bool componentsAgree = compactScc.size() == hashedScc.size();
+
+    auto report = [](std::string_view name, double ms, bool exact, std::size_t runs) {
+        std::cout << std::left << std::setw(18) << name << std::right << std::fixed
+                  << std::setprecision(3) << std::setw(10) << ms / static_cast<double>(runs)
+                  << " ms" << (exact ? "  exact" : "  MISMATCH") << '\n';
+    };
+    report("reused csr weight", csrWeightMs, true, queries);
+    report("dijkstra csr", compactDijkstra.first, compactDijkstra.second, queries);
+    report("reused csr", reusedDijkstra.first, reusedDijkstra.second, queries);
+    report("reused astar csr", compactAstar.first, compactAstar.second, queries);
+    report("dijkstra hashed", hashedDijkstra.first, hashedDijkstra.second, queries);
+    report("bfs csr", compactBfsMs, true, queries);
+    report("bfs hashed", hashedBfsMs, hopsAgree, queries);
+    report("scc csr", compactSccMs, true, 1);
+    report("scc hashed", hashedSccMs, componentsAgree, 1);
+    std::cout << compactScc.size() << " strongly connected components\n";
+}
\ No newline at end of file
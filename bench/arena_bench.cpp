@@ -0,0 +1,127 @@
+// Map construction and query batches on the default heap against std::pmr arenas.
+//
+//   bench_arena [side] [batches] [queries] [updates]
+//
+// Prints the time to build and destroy a city on the heap, in the locked Arena the app loads
+// into and in a bare monotonic arena, then the time of query batches with their paths on the heap
+// and in an arena released after every batch. Last the heap growth of a map in the arena under
+// updates that remove and restore connections, with the arena sealed after the build as the app
+// does and left growing.
+
+#include <malloc.h>
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory_resource>
+#include <random>
+#include <string_view>
+#include <vector>
+
+#include "Arena.h"
+#include "Query.h"
+#include "bench.h"
+
+using namespace citymap;
+
+int main(int argc, char* argv[]) {
+    std::size_t side    = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200;
+    std::size_t batches = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10;
+    std::size_t queries = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 20;
+    std::size_t updates = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 1000;
+
+    auto report = [](std::string_view name, double ms) {
+        std::cout << std::left << std::setw(24) << name << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(10) << ms << " ms\n";
+    };
+    std::cout << "city: " << side * side << " points\n";
+
+    auto begin = bench::Clock::now();
+    {
+        Map map;
+        bench::makeCity(map, side);
+    }
+    report("build heap", bench::millisecondsSince(begin));
+
+    begin = bench::Clock::now();
+    {
+        Arena arena;
+        Map map(&arena);
+        bench::makeCity(map, side);
+    }
+    report("build locked arena", bench::millisecondsSince(begin));
+
+    begin = bench::Clock::now();
+    {
+        std::pmr::monotonic_buffer_resource arena;
+        Map map(&arena);
+        bench::makeCity(map, side);
+    }
+    report("build monotonic arena", bench::millisecondsSince(begin));
+
+    Map map;
+    bench::makeCity(map, side);
+    map.compact();
+    std::mt19937_64 rng(3);
+    std::uniform_int_distribution<PointId> pick(0, map.size() - 1);
+
+    // both runs answer the same queries, the arena is released after every batch
+    auto run = [&](std::pmr::monotonic_buffer_resource* arena) {
+        std::pmr::memory_resource* resource = arena;
+        if (!arena) resource = std::pmr::get_default_resource();
+        rng.seed(3);
+        std::size_t points {};
+        for (std::size_t batch = 0; batch < batches; batch++) {
+            {
+                PolymorphicPathList paths(resource);
+                for (std::size_t i = 0; i < queries; i++)
+                    paths.push_back(
+                        map.findPath(CarQuery(pick(rng), pick(rng)), nullptr, resource));
+                for (auto& path : paths)
+                    points += path->points().size();
+            }
+            if (arena) arena->release();
+        }
+        return points;
+    };
+
+    begin           = bench::Clock::now();
+    auto heapPoints = run(nullptr);
+    report("queries heap", bench::millisecondsSince(begin));
+
+    std::pmr::monotonic_buffer_resource batchArena;
+    begin            = bench::Clock::now();
+    auto arenaPoints = run(&batchArena);
+    report("queries arena", bench::millisecondsSince(begin));
+    std::cout << (heapPoints == arenaPoints ? "same routes" : "MISMATCH") << '\n';
+
+    // the same connections go and come back, so a map that frees them stays the same size
+    auto churn = [&](bool sealed) {
+        Arena arena;
+        Map churned(&arena);
+        bench::makeCity(churned, side);
+        churned.compact();
+        if (sealed) arena.seal();
+        rng.seed(5);
+        std::vector<Map::ConnectionChange> changes;
+        for (std::size_t i = 0; i < 100; i++) {
+            auto from = pick(rng);
+            if (auto& connections = churned.connectionsOf(from); !connections.empty())
+                changes.push_back({from, *connections.begin(), false});
+        }
+        auto heap = [] {
+            auto info = ::mallinfo2();
+            return static_cast<double>(info.uordblks + info.hblkhd) / (1024.0 * 1024.0);
+        };
+        double before = heap();
+        for (std::size_t i = 0; i < updates; i++) {
+            churned.update(changes);
+            for (auto& change : changes)
+                change.connect = !change.connect;
+        }
+        return heap() - before;
+    };
+    std::cout << std::fixed << std::setprecision(1) << updates
+              << " update batches of 100 connections: heap grew " << churn(true)
+              << " MB with the arena sealed, " << churn(false) << " MB growing\n";
+}
\ No newline at end of file
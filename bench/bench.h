@@ -0,0 +1,105 @@
+#pragma once
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Map.h"
+
+// Helpers shared by the benchmark programs.
+namespace bench
+{
+
+    using Clock = std::chrono::steady_clock;
+
+    inline double millisecondsSince(Clock::time_point begin) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+    }
+
+    /**
+     * Grid-like city of side x side intersections with jittered coordinates, one way streets
+     * and a few diagonal footpaths. Ids are assigned in random order, like a file exported
+     * without any regard to geography.
+     */
+    inline void makeCity(citymap::Map& map, std::size_t side, std::uint64_t seed = 1) {
+        std::mt19937_64 rng(seed);
+        std::uniform_int_distribution<int> jitter(-3, 3);
+        std::bernoulli_distribution street(0.9), footpath(0.2);
+
+        std::vector<citymap::PointId> ids(side * side);
+        for (std::size_t i = 0; i < ids.size(); i++)
+            ids[i] = i;
+        std::ranges::shuffle(ids, rng);
+
+        for (std::size_t i = 0; i < ids.size(); i++) {
+            int x = static_cast<int>(i % side) * 10 + jitter(rng);
+            int y = static_cast<int>(i / side) * 10 + jitter(rng);
+            map.addPoint(ids[i], std::string("P").append(std::to_string(ids[i])), {x, y});
+        }
+
+        auto at = [&](std::size_t row, std::size_t col) { return ids[row * side + col]; };
+        for (std::size_t row = 0; row < side; row++)
+            for (std::size_t col = 0; col < side; col++) {
+                auto from = at(row, col);
+                if (col + 1 < side && street(rng)) map.addConnection(from, at(row, col + 1));
+                if (col > 0 && street(rng)) map.addConnection(from, at(row, col - 1));
+                if (row + 1 < side && street(rng)) map.addConnection(from, at(row + 1, col));
+                if (row > 0 && street(rng)) map.addConnection(from, at(row - 1, col));
+                if (row + 1 < side && col + 1 < side && footpath(rng))
+                    map.addConnection(from, at(row + 1, col + 1));
+            }
+    }
+
+    // Hardware cache miss counter of the calling thread, unavailable without perf support
+    // (e.g. in containers or with kernel.perf_event_paranoid > 2).
+    class CacheMisses {
+    public:
+        CacheMisses() {
+            perf_event_attr attr {};
+            attr.type           = PERF_TYPE_HARDWARE;
+            attr.size           = sizeof(attr);
+            attr.config         = PERF_COUNT_HW_CACHE_MISSES;
+            attr.disabled       = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv     = 1;
+            fd_ = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+
+        CacheMisses(const CacheMisses&) = delete;
+
+        ~CacheMisses() {
+            if (fd_ >= 0) ::close(fd_);
+        }
+
+        CacheMisses& operator=(const CacheMisses&) = delete;
+
+        bool available() const noexcept { return fd_ >= 0; }
+
+        void start() noexcept {
+            if (!available()) return;
+            ::ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ::ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+
+        std::uint64_t stop() noexcept {
+            std::uint64_t count {};
+            if (!available()) return count;
+            ::ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+            if (::read(fd_, &count, sizeof(count)) != sizeof(count)) count = 0;
+            return count;
+        }
+
+    private:
+        int fd_ {-1};
+    };
+
+}  // namespace bench
\ No newline at end of file
@@ -0,0 +1,74 @@
+// Full shortest path trees, serial Dijkstra against delta-stepping on growing thread counts.
+//
+//   bench_delta [side] [delta] [threads...]
+//
+// Prints the time per tree, the speedup over Dijkstra and whether every distance matched it.
+// delta 0 picks the engine's default, the thread counts default to 1 2 4 8.
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "CompactGraph.h"
+#include "DeltaStepping.h"
+#include "ThreadPool.h"
+#include "bench.h"
+
+using namespace citymap;
+
+int main(int argc, char* argv[]) {
+    std::size_t side = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+    double delta     = argc > 2 ? std::strtod(argv[2], nullptr) : 0.0;
+    std::vector<std::size_t> threads;
+    for (int i = 3; i < argc; i++)
+        threads.push_back(std::strtoul(argv[i], nullptr, 10));
+    if (threads.empty()) threads = {1, 2, 4, 8};
+
+    Map map;
+    bench::makeCity(map, side);
+    CompactGraph graph(map, VertexOrder::Hilbert);
+    std::cout << "city: " << graph.size() << " points, " << graph.edgeCount() << " connections\n";
+
+    std::mt19937_64 rng(11);
+    std::uniform_int_distribution<CompactGraph::Vertex> pick(0, graph.size() - 1);
+    auto source = pick(rng);
+
+    std::pair<std::string_view, metrics::Metric> profiles[] {
+        {"manhattan", metrics::manhattan},
+        {"euclidean", metrics::euclidean},
+    };
+    for (auto [name, metric] : profiles) {
+        SearchTree tree(graph);
+        auto begin = bench::Clock::now();
+        graphs::dijkstra(graph, source, graph.weight(metric), std::nullopt, tree);
+        double serialMs = bench::millisecondsSince(begin);
+
+        std::cout << '\n' << name << '\n'
+                  << std::fixed << std::setprecision(1) << std::left << std::setw(12)
+                  << "dijkstra" << std::right << std::setw(12) << serialMs << " ms\n";
+
+        for (auto count : threads) {
+            ThreadPool pool(count);
+            DeltaStepping engine(pool, delta);
+            engine.run(graph, source, metric);  // first touch outside the measurement
+            begin = bench::Clock::now();
+            engine.run(graph, source, metric);
+            double ms = bench::millisecondsSince(begin);
+
+            bool exact = true;
+            for (CompactGraph::Vertex v = 0; v < graph.size(); v++)
+                exact = exact && engine.distance(v) == tree.distance(v);
+
+            std::cout << std::left << std::setw(12) << (std::to_string(count) + " threads")
+                      << std::right << std::setw(12) << ms << " ms" << std::setw(8)
+                      << std::setprecision(2) << serialMs / ms << "x" << std::setprecision(1)
+                      << "  delta " << engine.delta() << (exact ? "  exact" : "  MISMATCH")
+                      << '\n';
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+// The car and pedestrian routes of point to point queries, two Dijkstra searches per query against
+// the fused pass of --type Both, over the input and Hilbert vertex orders and both adjacency
+// layouts.
+//
+//   bench_dual_search [side] [queries]
+//
+// Prints the time of both ways per configuration and checks the fused routes are the ones the two
+// searches find, point for point.
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "CompactGraph.h"
+#include "bench.h"
+
+using namespace citymap;
+
+int main(int argc, char* argv[]) {
+    std::size_t side    = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 300;
+    std::size_t queries = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100;
+
+    Map map;
+    bench::makeCity(map, side);
+    std::cout << "city: " << map.size() << " points, " << queries << " queries\n";
+
+    std::mt19937_64 rng(13);
+    auto ids = map.ids();
+    std::uniform_int_distribution<std::size_t> pick(0, ids.size() - 1);
+    std::vector<std::pair<PointId, PointId>> pairs(queries);
+    for (auto& pair : pairs)
+        pair = {ids[pick(rng)], ids[pick(rng)]};
+
+    std::pair<std::string_view, VertexOrder> orders[] {
+        {"input", VertexOrder::Input},
+        {"hilbert", VertexOrder::Hilbert},
+    };
+    std::pair<std::string_view, AdjacencyLayout> layouts[] {
+        {"plain", AdjacencyLayout::Plain},
+        {"packed", AdjacencyLayout::Packed},
+    };
+    std::cout << std::fixed << std::setprecision(1) << std::left << std::setw(10) << "order"
+              << std::setw(10) << "layout" << std::right << std::setw(14) << "two searches"
+              << std::setw(12) << "fused" << '\n';
+
+    bool same = true;
+    metrics::Metric metrics[] {metrics::manhattan, metrics::euclidean};
+    SearchTree tree;
+    DualSearchTree trees;
+    for (auto [orderName, order] : orders)
+        for (auto [layoutName, layout] : layouts) {
+            CompactGraph graph(map, order, layout);
+            std::vector<std::vector<CompactGraph::Vertex>> expected;
+            auto begin = bench::Clock::now();
+            for (auto [from, to] : pairs)
+                for (auto metric : metrics) {
+                    auto target = graph.vertexOf(to);
+                    graphs::dijkstra(graph, graph.vertexOf(from), graph.weight(metric), target,
+                                     tree);
+                    expected.push_back(tree.path(target));
+                }
+            double twoMs = bench::millisecondsSince(begin);
+
+            auto route = expected.begin();
+            begin      = bench::Clock::now();
+            for (auto [from, to] : pairs) {
+                auto target = graph.vertexOf(to);
+                graphs::dualDijkstra(graph, graph.vertexOf(from), target,
+                                     graph.dualArcs(metrics[0], metrics[1]), trees);
+                for (std::size_t i = 0; i < 2; i++)
+                    same = same && trees[i].path(target) == *route++;
+            }
+            double fusedMs = bench::millisecondsSince(begin);
+
+            std::cout << std::left << std::setw(10) << orderName << std::setw(10) << layoutName
+                      << std::right << std::setw(14) << twoMs << std::setw(12) << fusedMs << '\n';
+        }
+    std::cout << (same ? "same routes" : "MISMATCH") << '\n';
+    return same ? 0 : 1;
+}
\ No newline at end of file
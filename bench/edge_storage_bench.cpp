@@ -0,0 +1,151 @@
+// The edge storage policies of lib/graphs under random vertex and edge changes, for a directed and
+// an undirected graph, checked against a model of std::set (std::multiset for UnsortedVector,
+// which keeps duplicates).
+//
+//   bench_edge_storage [operations] [vertices] [seed]
+//
+// Few vertices make high degrees, so SmallVector spills to the heap and back and FlatHashSet
+// grows and shifts runs back on erase. Prints the time of every combination and whether every
+// edge list always matched the model.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <string_view>
+#include <vector>
+
+#include "DirectedGraph.h"
+#include "UndirectedGraph.h"
+#include "bench.h"
+
+using Key = int;
+
+// edge lists of the model, directed or both ways
+template<typename Edges>
+class Model {
+public:
+    explicit Model(bool undirected)
+        : undirected_(undirected) {}
+
+    bool contains(Key v) const { return vertices_.contains(v); }
+
+    void insertVertex(Key v) { vertices_.try_emplace(v); }
+
+    void removeVertex(Key v) {
+        vertices_.erase(v);
+        for (auto& [u, edges] : vertices_)
+            edges.erase(v);
+    }
+
+    void addEdge(Key a, Key b) {
+        vertices_.at(a).insert(b);
+        if (undirected_) vertices_.at(b).insert(a);
+    }
+
+    void removeEdge(Key a, Key b) {
+        vertices_.at(a).erase(b);
+        if (undirected_) vertices_.at(b).erase(a);
+    }
+
+    const std::map<Key, Edges>& vertices() const { return vertices_; }
+
+private:
+    bool undirected_;
+    std::map<Key, Edges> vertices_;
+};
+
+// true when the graph holds exactly the vertices and edges of the model
+template<typename Graph, typename Edges>
+static bool same(const Graph& graph, const Model<Edges>& model, Key vertices) {
+    if (graph.size() != model.vertices().size()) return false;
+    std::vector<Key> found;
+    for (auto& [v, edges] : model.vertices()) {
+        if (!graph.constains(v)) return false;
+        auto& list = graph.adjacent(v);
+        found.assign(list.begin(), list.end());
+        std::ranges::sort(found);
+        if (list.size() != edges.size() || !std::ranges::equal(found, edges)) return false;
+        for (Key u = 0; u < vertices; u++)
+            if (list.contains(u) != edges.contains(u)) return false;
+    }
+    return true;
+}
+
+// applies the same random changes to the graph and the model, comparing them after each one
+template<typename Graph, typename Edges>
+static bool run(Graph& graph, bool undirected, std::size_t operations, Key vertices,
+                std::uint64_t seed) {
+    Model<Edges> model(undirected);
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<Key> pick(0, vertices - 1);
+    std::discrete_distribution<int> operation({2, 1, 12, 6});  // vertex +/-, edge +/-
+    for (std::size_t i = 0; i < operations; i++) {
+        Key a = pick(rng), b = pick(rng);
+        switch (operation(rng)) {
+            case 0:
+                graph.insertVertex(a);
+                model.insertVertex(a);
+                break;
+            case 1:
+                graph.removeVertex(a);
+                model.removeVertex(a);
+                break;
+            case 2:
+                if (!model.contains(a) || !model.contains(b)) continue;
+                graph.addEdge(a, b);
+                model.addEdge(a, b);
+                break;
+            default:
+                if (!model.contains(a) || !model.contains(b)) continue;
+                graph.removeEdge(a, b);
+                model.removeEdge(a, b);
+        }
+        if (!same(graph, model, vertices)) return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t operations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    Key vertices           = argc > 2 ? std::atoi(argv[2]) : 40;
+    std::uint64_t seed     = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1;
+
+    using namespace graphs;
+    bool exact  = true;
+    auto report = [&](std::string_view name, auto graph, auto model) {
+        using Graph     = decltype(graph);
+        using Edges     = decltype(model);
+        bool undirected = name.starts_with("undirected");
+        auto begin      = bench::Clock::now();
+        bool matched    = run<Graph, Edges>(graph, undirected, operations, vertices, seed);
+        double ms       = bench::millisecondsSince(begin);
+        exact           = exact && matched;
+        std::cout << std::left << std::setw(30) << name << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(10) << ms << " ms"
+                  << (matched ? "  exact" : "  MISMATCH") << '\n';
+    };
+
+    std::cout << operations << " operations over " << vertices << " vertices\n";
+    report("directed unsorted vector", DirectedGraph<Key, void, storage::UnsortedVector> {},
+           std::multiset<Key> {});
+    report("directed sorted vector", DirectedGraph<Key, void, storage::SortedVector> {},
+           std::set<Key> {});
+    report("directed small vector", DirectedGraph<Key, void, storage::SmallVector> {},
+           std::set<Key> {});
+    report("directed flat hash set", DirectedGraph<Key, void, storage::FlatHashSet> {},
+           std::set<Key> {});
+    report("undirected unsorted vector", UndirectedGraph<Key, void, storage::UnsortedVector> {},
+           std::multiset<Key> {});
+    report("undirected sorted vector", UndirectedGraph<Key, void, storage::SortedVector> {},
+           std::set<Key> {});
+    report("undirected small vector", UndirectedGraph<Key, void, storage::SmallVector> {},
+           std::set<Key> {});
+    report("undirected flat hash set", UndirectedGraph<Key, void, storage::FlatHashSet> {},
+           std::set<Key> {});
+    return exact ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+// Fewest hops routes, a queue BFS over the CSR graph against the bit matrix, one query at a time
+// and in 64-lane multi-source sweeps.
+//
+//   bench_hops [side] [extra] [queries] [origins]
+//
+// extra adds that many random connections per point to points at most three blocks away, a
+// denser district the more there are. Queries start from any point, or from one of origins random
+// points (e.g. depots) when given, which the sweeps search from once for all their targets.
+// Prints the time per query and whether the hop counts match.
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "CompactGraph.h"
+#include "HopMatrix.h"
+#include "bench.h"
+
+using namespace citymap;
+
+using Vertex = CompactGraph::Vertex;
+
+// vertices on the fewest hops route (0 when unreachable), the baseline chasing the CSR arrays
+static std::size_t bfs(const CompactGraph& graph, Vertex source, Vertex target,
+                       std::vector<std::uint32_t>& hops) {
+    constexpr auto unseen = static_cast<std::uint32_t>(-1);
+    std::ranges::fill(hops, unseen);
+    std::queue<Vertex> queue;
+    hops[source] = 0;
+    queue.push(source);
+    while (!queue.empty() && hops[target] == unseen) {
+        auto u = queue.front();
+        queue.pop();
+        graph.forEachNeighbour(u, [&](Vertex v) {
+            if (hops[v] == unseen) {
+                hops[v] = hops[u] + 1;
+                queue.push(v);
+            }
+        });
+    }
+    return hops[target] == unseen ? 0 : hops[target] + 1;
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t side    = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 60;
+    std::size_t extra   = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 0;
+    std::size_t queries = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 256;
+    std::size_t origins = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 0;
+
+    Map map;
+    bench::makeCity(map, side);
+    std::mt19937_64 rng(5);
+    auto ids = map.ids();
+    std::ranges::sort(ids, {}, [&map](PointId id) {
+        auto point = map.valueOf(id);
+        return std::pair((point.y + 5) / 10, (point.x + 5) / 10);
+    });
+    std::uniform_int_distribution<int> offset(-3, 3);
+    for (std::size_t i = 0; i < ids.size(); i++)
+        for (std::size_t e = 0; e < extra; e++) {
+            auto row = static_cast<long>(i / side) + offset(rng);
+            auto col = static_cast<long>(i % side) + offset(rng);
+            auto n   = static_cast<long>(side);
+            if (row >= 0 && row < n && col >= 0 && col < n)
+                map.addConnection(ids[i], ids[static_cast<std::size_t>(row * n + col)]);
+        }
+
+    CompactGraph graph(map, VertexOrder::Hilbert);
+    HopMatrix matrix(graph);
+    std::cout << "city: " << graph.size() << " points, " << graph.edgeCount() << " connections, "
+              << queries << " queries\n";
+
+    std::uniform_int_distribution<Vertex> pick(0, static_cast<Vertex>(graph.size() - 1));
+    std::vector<Vertex> starts(origins);
+    for (auto& start : starts)
+        start = pick(rng);
+    std::vector<std::pair<Vertex, Vertex>> pairs(queries);
+    for (auto& pair : pairs)
+        pair = {starts.empty() ? pick(rng) : starts[rng() % starts.size()], pick(rng)};
+
+    std::vector<std::uint32_t> hops(graph.size());
+    std::vector<std::size_t> expected;
+    auto begin = bench::Clock::now();
+    for (auto [source, target] : pairs)
+        expected.push_back(bfs(graph, source, target, hops));
+    double queueMs = bench::millisecondsSince(begin);
+
+    begin = bench::Clock::now();
+    bool single = true;
+    for (std::size_t i = 0; i < pairs.size(); i++)
+        single = single && matrix.route(pairs[i].first, pairs[i].second).size() == expected[i];
+    double singleMs = bench::millisecondsSince(begin);
+
+    begin          = bench::Clock::now();
+    auto routes    = matrix.routes(pairs);
+    double sweepMs = bench::millisecondsSince(begin);
+    bool swept     = true;
+    for (std::size_t i = 0; i < pairs.size(); i++)
+        swept = swept && routes[i].size() == expected[i];
+
+    auto report = [queueMs, queries](std::string_view name, double ms, bool exact) {
+        std::cout << std::left << std::setw(12) << name << std::right << std::fixed
+                  << std::setprecision(3) << std::setw(10) << ms / queries << " ms/query"
+                  << std::setprecision(1) << std::setw(8) << queueMs / ms << "x"
+                  << (exact ? "  exact" : "  MISMATCH") << '\n';
+    };
+    report("queue bfs", queueMs, true);
+    report("bitset bfs", singleMs, single);
+    report("64-lane bfs", sweepMs, swept);
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+// Distance-only queries answered by hub labels against a Dijkstra search per query.
+//
+//   bench_hub_labels [side] [queries]
+//
+// Prints the preprocessing time, the average label size and the time per query of both, and
+// whether the label distances match the searched ones for both path types.
+
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "CompactGraph.h"
+#include "HubLabels.h"
+#include "bench.h"
+
+using namespace citymap;
+
+using Vertex = CompactGraph::Vertex;
+
+int main(int argc, char* argv[]) {
+    std::size_t side    = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100;
+    std::size_t queries = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000;
+
+    Map map;
+    bench::makeCity(map, side);
+    CompactGraph graph(map, VertexOrder::Hilbert);
+    std::cout << "city: " << graph.size() << " points, " << graph.edgeCount() << " connections, "
+              << queries << " queries\n";
+
+    auto begin = bench::Clock::now();
+    HubLabels labels(graph);
+    double preprocessMs = bench::millisecondsSince(begin);
+    std::cout << std::fixed << std::setprecision(1) << "preprocessing: " << preprocessMs
+              << " ms, " << static_cast<double>(labels.entries()) / (4.0 * graph.size())
+              << " hubs per label\n";
+
+    std::mt19937_64 rng(5);
+    std::uniform_int_distribution<Vertex> pick(0, static_cast<Vertex>(graph.size() - 1));
+    std::vector<std::pair<Vertex, Vertex>> pairs(queries);
+    for (auto& pair : pairs)
+        pair = {pick(rng), pick(rng)};
+
+    for (auto type : {PathType::Car, PathType::Pedestrian}) {
+        std::vector<double> expected;
+        SearchTree tree;
+        begin = bench::Clock::now();
+        for (auto [from, to] : pairs) {
+            graphs::dijkstra(graph, from, graph.weight(Map::metricOf(type)), to, tree);
+            expected.push_back(tree.distance(to));
+        }
+        double searchMs = bench::millisecondsSince(begin);
+
+        std::vector<double> found;
+        found.reserve(queries);
+        begin = bench::Clock::now();
+        for (auto [from, to] : pairs)
+            found.push_back(labels.distance(from, to, type));
+        double labelsMs = bench::millisecondsSince(begin);
+
+        // the labels sum the same lengths in another order, pedestrian ones may round apart
+        bool exact = true;
+        for (std::size_t i = 0; i < queries; i++) {
+            bool unreachable = std::isinf(found[i]) && std::isinf(expected[i]);
+            bool close       = std::abs(found[i] - expected[i]) <= 1e-9 * expected[i];
+            exact            = exact && (unreachable || close);
+        }
+        auto perQuery = [queries](double ms) { return ms * 1000.0 / static_cast<double>(queries); };
+        std::cout << (type == PathType::Car ? "car" : "pedestrian") << std::setprecision(3)
+                  << ": dijkstra " << perQuery(searchMs) << " us, hub labels "
+                  << perQuery(labelsMs) << " us" << (exact ? "  exact" : "  MISMATCH") << '\n';
+    }
+}
\ No newline at end of file
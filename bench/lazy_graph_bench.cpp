@@ -0,0 +1,152 @@
+// The eager connections loader against the lazy one (--lazy) on a city written out as input files.
+//
+//   bench_lazy_graph [side] [queries]
+//
+// Prints the load time and heap growth of both graphs, then the time of point to point queries
+// between nearby and between random points, the heap growth after each set and how many matrix
+// rows the lazy graph has parsed so far. The mapped matrix itself lives in the page cache and is
+// counted for neither. Checks that both graphs found the same distances.
+
+#include <malloc.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "FileHandler.h"
+#include "LazyGraph.h"
+#include "bench.h"
+
+using namespace citymap;
+
+// bytes allocated on the heap right now
+static double heapMegabytes() {
+    return static_cast<double>(::mallinfo2().uordblks) / (1024.0 * 1024.0);
+}
+
+// coordinates and connections matrix of the map, rows in the order of ids
+static void writeInputs(const Map& map, const std::vector<PointId>& ids,
+                        const std::filesystem::path& coordinates,
+                        const std::filesystem::path& connections) {
+    std::ofstream points(coordinates);
+    for (auto id : ids) {
+        auto& point = map.valueOf(id);
+        points << id << ' ' << map.nameOf(id) << ' ' << point.x << ' ' << point.y << '\n';
+    }
+    std::ofstream matrix(connections);
+    std::string row;
+    for (auto from : ids) {
+        row.assign(2 * ids.size(), ' ');
+        row.back() = '\n';
+        for (std::size_t c = 0; c < ids.size(); c++)
+            row[2 * c] = map.connectionsOf(from).contains(ids[c]) ? '1' : '0';
+        matrix << row;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t side    = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 60;
+    std::size_t queries = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 20;
+
+    auto directory   = std::filesystem::temp_directory_path() / "citymap_bench_lazy_graph";
+    auto coordinates = directory / "coords.txt";
+    auto connections = directory / "conn.txt";
+    using Pairs      = std::vector<std::pair<PointId, PointId>>;
+    std::pair<std::string_view, Pairs> sets[] {{"near", {}}, {"far", {}}};
+    {
+        Map city;
+        bench::makeCity(city, side);
+        auto ids = city.ids();
+        std::filesystem::create_directories(directory);
+        writeInputs(city, ids, coordinates, connections);
+
+        // near pairs are at most four blocks apart, far pairs anywhere in the city
+        std::mt19937_64 rng(11);
+        std::uniform_int_distribution<std::size_t> pick(0, ids.size() - 1);
+        std::vector<PointId> around;
+        for (std::size_t q = 0; q < queries; q++) {
+            auto from = ids[pick(rng)];
+            auto& a   = city.valueOf(from);
+            around.clear();
+            for (auto id : ids) {
+                auto& b = city.valueOf(id);
+                if (std::abs(a.x - b.x) + std::abs(a.y - b.y) <= 40) around.push_back(id);
+            }
+            sets[0].second.emplace_back(from, around[rng() % around.size()]);
+            sets[1].second.emplace_back(ids[pick(rng)], ids[pick(rng)]);
+        }
+    }
+    std::cout << side * side << " points, matrix of "
+              << std::filesystem::file_size(connections) / (1024 * 1024) << " MB, " << queries
+              << " queries per set\n"
+              << std::fixed << std::setprecision(1) << std::left << std::setw(8) << "graph"
+              << std::setw(8) << "set" << std::right << std::setw(12) << "ms" << std::setw(12)
+              << "heap MB" << std::setw(16) << "rows parsed" << '\n';
+
+    auto report = [](std::string_view name, std::string_view set, double ms, double mb,
+                     std::string_view rows) {
+        std::cout << std::left << std::setw(8) << name << std::setw(8) << set << std::right
+                  << std::setw(12) << ms << std::setw(12) << mb << std::setw(16) << rows << '\n';
+    };
+
+    // the snapshot the searches run on is built with the graph
+    FileHandler eagerFiles;
+    Map eager;
+    eagerFiles.loadCoordinates(coordinates, eager);
+    double heap = heapMegabytes();
+    auto begin  = bench::Clock::now();
+    eagerFiles.loadConnections(connections, eager);
+    eager.compact();
+    if (eagerFiles.fail()) {
+        std::cerr << eagerFiles.error() << '\n';
+        return 1;
+    }
+    report("eager", "load", bench::millisecondsSince(begin), heapMegabytes() - heap, "all");
+    std::vector<double> expected;
+    for (auto& [set, pairs] : sets) {
+        begin = bench::Clock::now();
+        for (auto [from, to] : pairs)
+            expected.push_back(eager.findPath(CarQuery(from, to))->distance());
+        report("eager", set, bench::millisecondsSince(begin), heapMegabytes() - heap, "all");
+    }
+
+    FileHandler lazyFiles;
+    Map points;
+    std::unique_ptr<LazyGraph> lazy;
+    lazyFiles.loadCoordinates(coordinates, points);
+    heap  = heapMegabytes();
+    begin = bench::Clock::now();
+    lazyFiles.loadLazyConnections(connections, lazy, points);
+    if (lazyFiles.fail()) {
+        std::cerr << lazyFiles.error() << '\n';
+        return 1;
+    }
+    auto parsed = [&] {
+        return std::to_string(lazy->decoded()) + " of " + std::to_string(lazy->rows());
+    };
+    report("lazy", "load", bench::millisecondsSince(begin), heapMegabytes() - heap, parsed());
+    bool same = true;
+    auto next = expected.begin();
+    for (auto& [set, pairs] : sets) {
+        begin = bench::Clock::now();
+        for (auto [from, to] : pairs) {
+            double found = lazy->findPath(CarQuery(from, to))->distance(), want = *next++;
+            same         = same && (std::isinf(want) ? std::isinf(found)
+                                                     : std::abs(found - want) <= 1e-9 * want);
+        }
+        report("lazy", set, bench::millisecondsSince(begin), heapMegabytes() - heap, parsed());
+    }
+
+    std::filesystem::remove_all(directory);
+    std::cout << (same ? "same distances" : "MISMATCH") << '\n';
+    return same ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+// Point to point searches over plain and packed adjacency lists at several city sizes.
+//
+//   bench_packed_adjacency [queries] [side...]
+//
+// Prints the bytes per arc of both layouts, query time and hardware cache misses, for the input
+// (random) and the Hilbert vertex order, and whether the packed searches found the same distances.
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "CompactGraph.h"
+#include "bench.h"
+
+using namespace citymap;
+
+int main(int argc, char* argv[]) {
+    std::size_t queries = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 50;
+    std::vector<std::size_t> sides;
+    for (int i = 2; i < argc; i++)
+        sides.push_back(std::strtoul(argv[i], nullptr, 10));
+    if (sides.empty()) sides = {100, 300, 700};
+
+    std::pair<std::string_view, VertexOrder> orders[] {
+        {"input", VertexOrder::Input},
+        {"hilbert", VertexOrder::Hilbert},
+    };
+    std::pair<std::string_view, AdjacencyLayout> layouts[] {
+        {"plain", AdjacencyLayout::Plain},
+        {"packed", AdjacencyLayout::Packed},
+    };
+
+    std::cout << std::fixed << std::left << std::setw(10) << "points" << std::setw(10) << "order"
+              << std::setw(8) << "layout" << std::right << std::setw(12) << "bytes/arc"
+              << std::setw(12) << "query ms" << std::setw(16) << "cache misses" << '\n';
+
+    bench::CacheMisses misses;
+    SearchTree tree;
+    bool same = true;
+    for (auto side : sides) {
+        Map map;
+        bench::makeCity(map, side);
+        std::mt19937_64 rng(7);
+        std::uniform_int_distribution<PointId> pick(0, map.size() - 1);
+        std::vector<std::pair<PointId, PointId>> pairs(queries);
+        for (auto& pair : pairs)
+            pair = {pick(rng), pick(rng)};
+
+        for (auto [orderName, order] : orders) {
+            std::vector<double> expected;
+            for (auto [layoutName, layout] : layouts) {
+                CompactGraph graph(map, order, layout);
+                // one arc per edge in each direction
+                double perArc = static_cast<double>(graph.adjacencyBytes()) /
+                                (2.0 * static_cast<double>(graph.edgeCount()));
+
+                std::vector<double> found;
+                found.reserve(queries);
+                tree.clear(graph);  // first touch outside the measurement
+                misses.start();
+                auto begin = bench::Clock::now();
+                for (auto [from, to] : pairs) {
+                    auto target = graph.vertexOf(to);
+                    graphs::dijkstra(graph, graph.vertexOf(from), graph.weight(metrics::manhattan),
+                                     target, tree);
+                    found.push_back(tree.distance(target));
+                }
+                double queryMs = bench::millisecondsSince(begin);
+                auto count     = misses.stop();
+
+                if (expected.empty())
+                    expected = found;
+                else
+                    same = same && found == expected;
+
+                std::cout << std::left << std::setw(10) << graph.size() << std::setw(10)
+                          << orderName << std::setw(8) << layoutName << std::right
+                          << std::setprecision(2) << std::setw(12) << perArc
+                          << std::setprecision(1) << std::setw(12) << queryMs << std::setw(16);
+                if (misses.available())
+                    std::cout << count;
+                else
+                    std::cout << "n/a";
+                std::cout << '\n';
+            }
+        }
+    }
+    std::cout << (same ? "same distances" : "MISMATCH") << '\n';
+}
\ No newline at end of file
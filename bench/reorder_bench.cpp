@@ -0,0 +1,81 @@
+// Point to point searches over the same city with every vertex order.
+//
+//   bench_reorder [side] [queries] [order]
+//
+// Prints build time, mean edge span, query time and hardware cache misses per order.
+// With an order argument only that one runs, e.g. for `perf stat -e cache-misses`.
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "CompactGraph.h"
+#include "bench.h"
+
+using namespace citymap;
+
+int main(int argc, char* argv[]) {
+    std::size_t side    = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 400;
+    std::size_t queries = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 200;
+    std::string_view only = argc > 3 ? argv[3] : "";
+
+    Map map;
+    bench::makeCity(map, side);
+    std::cout << "city: " << map.size() << " points, " << side << "x" << side << " grid, "
+              << queries << " queries\n";
+
+    std::mt19937_64 rng(7);
+    std::uniform_int_distribution<PointId> pick(0, map.size() - 1);
+    std::vector<std::pair<PointId, PointId>> pairs(queries);
+    for (auto& pair : pairs)
+        pair = {pick(rng), pick(rng)};
+
+    std::pair<std::string_view, VertexOrder> orders[] {
+        {"input", VertexOrder::Input},
+        {"hilbert", VertexOrder::Hilbert},
+        {"bfs", VertexOrder::Bfs},
+        {"rcm", VertexOrder::Rcm},
+    };
+
+    std::cout << std::fixed << std::left << std::setw(10) << "order" << std::right
+              << std::setw(12) << "build ms" << std::setw(12) << "edge span" << std::setw(14)
+              << "query ms" << std::setw(16) << "cache misses" << std::setw(16) << "checksum\n";
+
+    bench::CacheMisses misses;
+    SearchTree tree;
+    for (auto [name, order] : orders) {
+        if (!only.empty() && only != name) continue;
+
+        auto begin = bench::Clock::now();
+        CompactGraph graph(map, order);
+        double buildMs = bench::millisecondsSince(begin);
+
+        double checksum {};
+        tree.clear(graph);  // first touch outside the measurement
+        misses.start();
+        begin = bench::Clock::now();
+        for (auto [from, to] : pairs) {
+            auto target = graph.vertexOf(to);
+            graphs::dijkstra(graph, graph.vertexOf(from), graph.weight(metrics::manhattan), target,
+                             tree);
+            double distance = tree.distance(target);
+            if (distance != std::numeric_limits<double>::infinity()) checksum += distance;
+        }
+        double queryMs = bench::millisecondsSince(begin);
+        auto count     = misses.stop();
+
+        std::cout << std::left << std::setw(10) << name << std::right << std::setprecision(1)
+                  << std::setw(12) << buildMs << std::setw(12) << graph.edgeSpan()
+                  << std::setw(14) << queryMs << std::setw(16);
+        if (misses.available())
+            std::cout << count;
+        else
+            std::cout << "n/a";
+        std::cout << std::setw(15) << checksum << '\n';
+    }
+}
\ No newline at end of file
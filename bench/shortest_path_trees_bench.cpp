@@ -0,0 +1,96 @@
+// Pinned shortest path trees repaired through batches of connection changes, as --serve does.
+//
+//   bench_shortest_path_trees [side] [depots] [batches] [batch size]
+//
+// Prints the time per Map::update, which patches the snapshot and repairs the trees of every
+// depot, against computing the trees again on the patched snapshot, and how many labels the
+// repairs settled again. Then checks that the repaired distances match fresh trees for both path
+// types.
+
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "CompactGraph.h"
+#include "ShortestPathTrees.h"
+#include "bench.h"
+
+using namespace citymap;
+
+using Vertex = CompactGraph::Vertex;
+
+int main(int argc, char* argv[]) {
+    std::size_t side      = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 150;
+    std::size_t depots    = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 8;
+    std::size_t batches   = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 50;
+    std::size_t batchSize = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 4;
+
+    Map map;
+    bench::makeCity(map, side);
+    auto graph = map.compact();
+    std::mt19937_64 rng(3);
+    std::uniform_int_distribution<Vertex> vertex(0, static_cast<Vertex>(graph->size() - 1));
+    std::vector<Vertex> sources(depots);
+    for (auto& source : sources)
+        source = vertex(rng);
+    map.shortestPathTrees(std::make_shared<ShortestPathTrees>(*graph, sources));
+    std::cout << "city: " << graph->size() << " points, " << graph->edgeCount() << " connections, "
+              << depots << " depots, " << batches << " batches of " << batchSize << " changes\n";
+
+    // removes a connection of a random point or connects it to a point two streets away
+    auto ids = map.ids();
+    std::uniform_int_distribution<std::size_t> pick(0, ids.size() - 1);
+    std::bernoulli_distribution removal(0.5);
+    std::vector<Map::ConnectionChange> changes;
+    double updateMs = 0.0, computeMs = 0.0;
+    std::size_t repaired {};
+    for (std::size_t b = 0; b < batches; b++) {
+        changes.clear();
+        while (changes.size() < batchSize) {
+            auto from         = ids[pick(rng)];
+            auto& connections = map.connectionsOf(from);
+            if (connections.empty()) continue;
+            auto next = *connections.begin();
+            if (removal(rng))
+                changes.push_back({from, next, false});
+            else if (auto& further = map.connectionsOf(next); !further.empty())
+                changes.push_back({from, *further.begin(), true});
+        }
+        auto begin = bench::Clock::now();
+        map.update(changes);
+        updateMs += bench::millisecondsSince(begin);
+        if (auto trees = map.shortestPathTrees(); trees) repaired += trees->repaired();
+
+        begin = bench::Clock::now();
+        ShortestPathTrees fresh(*map.compact(), sources);
+        computeMs += bench::millisecondsSince(begin);
+    }
+
+    graph         = map.compact();
+    auto trees    = map.shortestPathTrees();
+    bool repairs  = trees && trees->fits(*graph);
+    auto perBatch = [batches](double ms) { return ms / static_cast<double>(batches); };
+    std::cout << std::fixed << std::setprecision(2) << "update: " << perBatch(updateMs)
+              << " ms per batch, computing the trees " << perBatch(computeMs) << " ms, "
+              << repaired / batches << " labels settled again per batch"
+              << (repairs ? "" : "  trees dropped") << '\n';
+    if (!repairs) return 1;
+
+    ShortestPathTrees fresh(*graph, sources);
+    bool same = true;
+    for (auto source : trees->sources())
+        for (auto type : {PathType::Car, PathType::Pedestrian})
+            for (Vertex v = 0; v < graph->size(); v++) {
+                double expected = fresh.distance(source, v, type);
+                double found    = trees->distance(source, v, type);
+                same            = same && (std::isinf(expected) ? std::isinf(found)
+                                                                : std::abs(found - expected)
+                                                                      <= 1e-9 * expected);
+            }
+    std::cout << (same ? "same distances" : "MISMATCH") << '\n';
+    return same ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+// Batches of connection changes applied to a map with an overlay and landmarks, as --serve does.
+//
+//   bench_updates [side] [batches] [batch size] [queries]
+//
+// Prints the time per Map::update, which patches the snapshot and repairs both indexes, against
+// rebuilding the snapshot and indexes from scratch. Then checks that the repaired indexes still
+// fit the map and that their distances match Dijkstra on the final snapshot for both path types.
+
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "CompactGraph.h"
+#include "Landmarks.h"
+#include "Overlay.h"
+#include "bench.h"
+
+using namespace citymap;
+
+using Vertex = CompactGraph::Vertex;
+
+int main(int argc, char* argv[]) {
+    std::size_t side      = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 150;
+    std::size_t batches   = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 50;
+    std::size_t batchSize = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 4;
+    std::size_t queries   = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 200;
+
+    Map map;
+    bench::makeCity(map, side);
+    map.layout(VertexOrder::Hilbert);
+    auto begin = bench::Clock::now();
+    auto graph = map.compact();
+    map.overlay(std::make_shared<Overlay>(*graph));
+    map.landmarks(std::make_shared<Landmarks>(*graph));
+    double rebuildMs = bench::millisecondsSince(begin);
+    std::cout << "city: " << graph->size() << " points, " << graph->edgeCount()
+              << " connections, " << batches << " batches of " << batchSize << " changes\n";
+
+    // removes a connection of a random point or connects it to a point two streets away
+    std::mt19937_64 rng(3);
+    auto ids = map.ids();
+    std::uniform_int_distribution<std::size_t> pick(0, ids.size() - 1);
+    std::bernoulli_distribution removal(0.5);
+    std::vector<Map::ConnectionChange> changes;
+    double updateMs = 0.0;
+    for (std::size_t b = 0; b < batches; b++) {
+        changes.clear();
+        while (changes.size() < batchSize) {
+            auto from         = ids[pick(rng)];
+            auto& connections = map.connectionsOf(from);
+            if (connections.empty()) continue;
+            auto next = *connections.begin();
+            if (removal(rng))
+                changes.push_back({from, next, false});
+            else if (auto& further = map.connectionsOf(next); !further.empty())
+                changes.push_back({from, *further.begin(), true});
+        }
+        begin = bench::Clock::now();
+        map.update(changes);
+        updateMs += bench::millisecondsSince(begin);
+    }
+
+    graph         = map.compact();
+    auto overlay  = map.overlay();
+    auto alt      = map.landmarks();
+    bool repaired = overlay && overlay->fits(*graph) && alt && alt->fits(*graph);
+    std::cout << std::fixed << std::setprecision(2)
+              << "update: " << updateMs / static_cast<double>(batches) << " ms per batch, rebuild "
+              << rebuildMs << " ms" << (repaired ? "" : "  indexes dropped") << '\n';
+    if (!repaired) return 1;
+
+    std::uniform_int_distribution<Vertex> vertex(0, static_cast<Vertex>(graph->size() - 1));
+    SearchTree tree;
+    std::vector<Vertex> route;
+    bool same = true;
+    for (std::size_t q = 0; q < queries; q++) {
+        auto from = vertex(rng), to = vertex(rng);
+        for (auto type : {PathType::Car, PathType::Pedestrian}) {
+            auto weight = graph->weight(Map::metricOf(type));
+            graphs::dijkstra(*graph, from, weight, to, tree);
+            double expected = tree.distance(to);
+            double viaCells = overlay->search(*graph, type, from, to, tree, route);
+            graphs::astar(*graph, from, to, weight,
+                          [&](Vertex v) { return alt->lowerBound(v, to, type); }, tree);
+            double viaAlt = tree.distance(to);
+            for (double found : {viaCells, viaAlt})
+                same = same && (std::isinf(expected) ? std::isinf(found)
+                                                     : std::abs(found - expected)
+                                                           <= 1e-9 * expected);
+        }
+    }
+    std::cout << (same ? "same distances" : "MISMATCH") << '\n';
+    return same ? 0 : 1;
+}
\ No newline at end of file
@@ -5,36 +5,34 @@
 namespace graphs
 {
 
-    template<typename Key, typename Value = void>
-    class DirectedGraph : public GraphBase<Key, Value> {
+    // Sorted edges by default: removing a vertex has to look it up in the edges of every other
+    // vertex, a binary search each instead of a linear scan.
+    template<typename Key, typename Value = void,
+             template<typename...> class EdgeStorage = storage::SortedVector>
+    class DirectedGraph : public GraphBase<Key, Value, EdgeStorage> {
+        using Base = GraphBase<Key, Value, EdgeStorage>;
+
     public:
-        using typename GraphBase<Key, Value>::key_type;
-        using typename GraphBase<Key, Value>::value_type;
-        using typename GraphBase<Key, Value>::edge_list;
-        using typename GraphBase<Key, Value>::size_type;
+        using typename Base::key_type;
+        using typename Base::value_type;
+        using typename Base::edge_list;
+        using typename Base::size_type;
 
         DirectedGraph()  = default;
         ~DirectedGraph() = default;
 
         void removeVertex(const key_type& vertex) {
             std::ranges::for_each(this->vertices_,
-                                  [&vertex](auto& ref) { std::erase(ref.second.edges, vertex); });
+                                  [&vertex](auto& ref) { ref.second.edges.erase(vertex); });
             this->vertices_.erase(vertex);
         }
 
         void addEdge(const key_type& a, const key_type& b) {
-            // if constexpr (std::is_pointer<edge_type>) {
-            // auto a_ptr = this->vertices_.find(a);
-            // }
-            // else {
-            // this->vertices_.at(a).edges.emplace_back(b);
-            // }
-
-            this->vertices_.at(a).edges.emplace_back(b);
+            this->vertices_.at(a).edges.insert(b);
         }
 
         void removeEdge(const key_type& a, const key_type& b) {
-            std::erase(this->vertices_.at(a).edges, b);
+            this->vertices_.at(a).edges.erase(b);
         }
     };
 
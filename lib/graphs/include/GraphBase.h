@@ -1,21 +1,28 @@
 #pragma once
 
 #include <algorithm>
+#include <ranges>
 #include <unordered_map>
 #include <vector>
 
+#include "edge_storage.h"
 #include "graph_traits.h"
 
 namespace graphs
 {
 
-    template<typename Key, typename Value = void>
+    // EdgeStorage is the container of the edges of a vertex, one of graphs::storage. It is
+    // instantiated with the key type alone, further parameters take their defaults.
+    template<typename Key, typename Value = void,
+             template<typename...> class EdgeStorage = storage::UnsortedVector>
     class GraphBase {
     public:
-        using key_type   = Key;
-        using value_type = Value;
-        // using edge_list = std::conditional_t<sizeof(key_type) <= sizeof(void*) && std::is_trivially_destructible_v<key_type>, std::vector<key_type>, std::vector<key_type*>>;
-        using edge_list = std::vector<key_type>;
+        using key_type    = Key;
+        using value_type  = Value;
+        using edge_list   = EdgeStorage<key_type>;
+        using vertex_type = key_type;  // graphs::graph
+
+        static_assert(storage::edge_storage<edge_list>);
 
     protected:
         template<typename V, bool = std::is_void_v<V>>
@@ -42,13 +49,15 @@ namespace graphs
         size_type size() const noexcept { return vertices_.size(); }
 
         bool adjacent(const key_type& a, const key_type& b) const {
-            return std::ranges::contains(vertices_.at(a).edges, b);
+            return vertices_.at(a).edges.contains(b);
         }
 
         const edge_list& adjacent(const key_type& vertex) const {
             return vertices_.at(vertex).edges;
         }
 
+        auto vertices() const { return std::views::keys(vertices_); }
+
         bool constains(const key_type& vertex) const { return vertices_.contains(vertex); }
 
         bool empty() const noexcept { return vertices_.empty(); }
@@ -59,15 +68,13 @@ namespace graphs
 
         const vertices_map& data() const noexcept { return vertices_; }
 
-        value_type& operator[](const key_type& vertex) {
-            static_assert(graph_traits::is_not_void_v<value_type>,
-                          "To use this function, value_type cannot be void.");
+        template<typename V = value_type>
+        graph_traits::enable_if_not_void_t<V, V&> operator[](const key_type& vertex) {
             return vertices_.at(vertex).val;
         }
 
-        const value_type& operator[](const key_type& vertex) const {
-            static_assert(graph_traits::is_not_void_v<value_type>,
-                          "To use this function, value_type cannot be void.");
+        template<typename V = value_type>
+        graph_traits::enable_if_not_void_t<V, const V&> operator[](const key_type& vertex) const {
             return vertices_.at(vertex).val;
         }
 
@@ -102,7 +109,7 @@ namespace graphs
 
         void removeVertex(const key_type& vertex) {
             std::ranges::for_each(vertices_,
-                                  [&vertex](auto& ref) { std::erase(ref.second.edges, vertex); });
+                                  [&vertex](auto& ref) { ref.second.edges.erase(vertex); });
             vertices_.erase(vertex);
         }
 
@@ -5,39 +5,38 @@
 namespace graphs
 {
 
-    template<typename Key, typename Value = void>
-    class UndirectedGraph : public GraphBase<Key, Value> {
+    // Edges are symmetric, so removing a vertex only touches its neighbours and their lists stay
+    // as short as a vertex degree: kept inline by default, no allocation per vertex.
+    template<typename Key, typename Value = void,
+             template<typename...> class EdgeStorage = storage::SmallVector>
+    class UndirectedGraph : public GraphBase<Key, Value, EdgeStorage> {
+        using Base = GraphBase<Key, Value, EdgeStorage>;
+
     public:
-        using typename GraphBase<Key, Value>::key_type;
-        using typename GraphBase<Key, Value>::value_type;
-        using typename GraphBase<Key, Value>::edge_list;
-        using typename GraphBase<Key, Value>::size_type;
+        using typename Base::key_type;
+        using typename Base::value_type;
+        using typename Base::edge_list;
+        using typename Base::size_type;
 
         UndirectedGraph()  = default;
         ~UndirectedGraph() = default;
 
         void removeVertex(const key_type& vertex) {
-            std::ranges::for_each(this->vertices_,
-                                  [&vertex](auto& ref) { std::erase(ref.second.edges, vertex); });
-            this->vertices_.erase(vertex);
+            auto it = this->vertices_.find(vertex);
+            if (it == this->vertices_.end()) return;
+            for (auto& neighbour : it->second.edges)
+                if (neighbour != vertex) this->vertices_.at(neighbour).edges.erase(vertex);
+            this->vertices_.erase(it);
         }
 
         void addEdge(const key_type& a, const key_type& b) {
-            // if constexpr (std::is_pointer<edge_type>) {
-            // auto a_ptr = this->vertices_.find(a);
-            // }
-            // else {
-            // this->vertices_.at(a).edges.emplace_back(b);
-            // this->vertices_.at(b).edges.emplace_back(a);
-            // }
-
-            this->vertices_.at(a).edges.emplace_back(b);
-            this->vertices_.at(b).edges.emplace_back(a);
+            this->vertices_.at(a).edges.insert(b);
+            this->vertices_.at(b).edges.insert(a);
         }
 
         void removeEdge(const key_type& a, const key_type& b) {
-            std::erase(this->vertices_.at(a).edges, b);
-            std::erase(this->vertices_.at(b).edges, a);
+            this->vertices_.at(a).edges.erase(b);
+            this->vertices_.at(b).edges.erase(a);
         }
     };
 
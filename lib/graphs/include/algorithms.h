@@ -0,0 +1,441 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <ranges>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace graphs
+{
+
+    /**
+     * A graph the algorithms run on: vertex count, the vertices and the adjacency of one of them.
+     * Adjacency has to be a borrowed range (a reference or a view into the graph), searches keep
+     * iterators into it. Graphs numbering their vertices 0..size()-1 declare dense_vertices and
+     * get flat arrays instead of hash maps for their labels.
+     */
+    template<typename G>
+    concept graph = requires(const G& g, const typename G::vertex_type& v) {
+        typename G::vertex_type;
+        { g.size() } -> std::convertible_to<std::size_t>;
+        { g.adjacent(v) } -> std::ranges::borrowed_range;
+        { g.vertices() } -> std::ranges::input_range;
+        requires std::convertible_to<std::ranges::range_value_t<decltype(g.adjacent(v))>,
+                                     typename G::vertex_type>;
+    };
+
+    template<graph G>
+    using vertex_t = G::vertex_type;
+
+    // graphs that visit the adjacency of a vertex faster than iterating it, e.g. compressed lists
+    template<typename G>
+    concept visitable_graph = graph<G> && requires(const G& g, const vertex_t<G>& v) {
+        g.forEachNeighbour(v, [](const vertex_t<G>&) {});
+    };
+
+    // f(v) for every edge u -> v
+    template<graph G, typename F>
+    void forEachNeighbour(const G& graph, const vertex_t<G>& u, F f) {
+        if constexpr (visitable_graph<G>)
+            graph.forEachNeighbour(u, f);
+        else
+            for (const vertex_t<G>& v : graph.adjacent(u))
+                f(v);
+    }
+
+    template<typename G>
+    concept dense_graph = graph<G> && std::unsigned_integral<vertex_t<G>> && requires {
+        requires G::dense_vertices;
+    };
+
+    // weight(u, v) of the edge u -> v
+    template<typename W, typename G>
+    concept weight_function = graph<G> && std::regular_invocable<W&, vertex_t<G>, vertex_t<G>>
+                              && std::is_arithmetic_v<std::invoke_result_t<W&, vertex_t<G>,
+                                                                           vertex_t<G>>>;
+
+    // potential(v), a lower bound of the distance from v to the target
+    template<typename P, typename G>
+    concept potential_function = graph<G> && std::regular_invocable<P&, vertex_t<G>>
+                                 && std::is_arithmetic_v<std::invoke_result_t<P&, vertex_t<G>>>;
+
+    // Per vertex values of a search: a flat array for dense graphs, a hash map otherwise. Dense
+    // values carry the round they were set in, so clear() forgets them without touching them.
+    template<graph G, typename T>
+    class VertexMap {
+    public:
+        VertexMap() = default;
+        explicit VertexMap(const G& graph) { clear(graph); }
+
+        void clear(const G& graph) {
+            if constexpr (dense_graph<G>) {
+                if (values_.size() < graph.size()) values_.resize(graph.size());
+                if (++round_ == 0) {  // wrapped around, old rounds could match again
+                    for (auto& slot : values_)
+                        slot.round = 0;
+                    round_ = 1;
+                }
+            }
+            else
+                values_.clear();
+        }
+
+        T* find(const vertex_t<G>& v) {
+            if constexpr (dense_graph<G>)
+                return values_[v].round == round_ ? &values_[v].value : nullptr;
+            else {
+                auto it = values_.find(v);
+                return it == values_.end() ? nullptr : &it->second;
+            }
+        }
+
+        const T* find(const vertex_t<G>& v) const { return const_cast<VertexMap*>(this)->find(v); }
+
+        T& operator[](const vertex_t<G>& v) { return *insert(v).first; }
+
+        // the value of v and whether it was just added (value initialized), one lookup for both
+        std::pair<T*, bool> insert(const vertex_t<G>& v) {
+            if constexpr (dense_graph<G>) {
+                auto& slot = values_[v];
+                if (slot.round == round_) return {&slot.value, false};
+                slot = {T {}, round_};
+                return {&slot.value, true};
+            }
+            else {
+                auto [it, inserted] = values_.try_emplace(v);
+                return {&it->second, inserted};
+            }
+        }
+
+    private:
+        struct Slot {
+            T value;
+            std::uint32_t round;
+        };
+
+        std::conditional_t<dense_graph<G>, std::vector<Slot>, std::unordered_map<vertex_t<G>, T>>
+            values_;
+        std::uint32_t round_ {};
+    };
+
+    // Distances and parents of the vertices a search reached, sources are their own parents.
+    // Searches given a tree clear it first, one kept across searches reuses its memory.
+    template<graph G, typename Distance>
+    class SearchTree {
+    public:
+        struct Label {
+            Distance distance;
+            vertex_t<G> parent;
+        };
+
+        struct Entry {
+            Distance key, distance;
+            vertex_t<G> vertex;
+        };
+
+        SearchTree() = default;
+        explicit SearchTree(const G& graph)
+            : labels_(graph) {}
+
+        void clear(const G& graph) {
+            labels_.clear(graph);
+            frontier_.clear();
+        }
+
+        bool reached(const vertex_t<G>& v) const { return labels_.find(v) != nullptr; }
+
+        Distance distance(const vertex_t<G>& v) const {
+            auto label = labels_.find(v);
+            if (label) return label->distance;
+            if constexpr (std::numeric_limits<Distance>::has_infinity)
+                return std::numeric_limits<Distance>::infinity();
+            else
+                return std::numeric_limits<Distance>::max();
+        }
+
+        std::optional<vertex_t<G>> parent(const vertex_t<G>& v) const {
+            auto label = labels_.find(v);
+            return label ? std::optional(label->parent) : std::nullopt;
+        }
+
+        // vertices from the source to v, empty when v was not reached
+        std::vector<vertex_t<G>> path(vertex_t<G> v) const {
+            std::vector<vertex_t<G>> path;
+            for (auto label = labels_.find(v); label; label = labels_.find(v)) {
+                path.push_back(v);
+                if (label->parent == v) break;
+                v = label->parent;
+            }
+            std::ranges::reverse(path);
+            return path;
+        }
+
+        VertexMap<G, Label>& labels() noexcept { return labels_; }
+        std::vector<Entry>& frontier() noexcept { return frontier_; }  // heap of the searches
+
+    private:
+        VertexMap<G, Label> labels_;
+        std::vector<Entry> frontier_;
+    };
+
+    // The trees of the two searches of dualDijkstra, and the arcs the first one weighed for the
+    // second: per expanded vertex a run of its arcs with their second length.
+    template<graph G, typename Distance>
+    class DualSearchTree {
+    public:
+        using Arc = std::pair<vertex_t<G>, Distance>;
+
+        DualSearchTree() = default;
+
+        void clear(const G& graph) {
+            for (auto& tree : trees_)
+                tree.clear(graph);
+            stashed_.clear(graph);
+            stash_.clear();
+        }
+
+        SearchTree<G, Distance>& operator[](std::size_t i) noexcept { return trees_[i]; }
+        const SearchTree<G, Distance>& operator[](std::size_t i) const noexcept {
+            return trees_[i];
+        }
+
+        std::vector<Arc>& stash() noexcept { return stash_; }
+        VertexMap<G, std::pair<std::size_t, std::size_t>>& stashed() noexcept { return stashed_; }
+
+    private:
+        std::array<SearchTree<G, Distance>, 2> trees_;
+        VertexMap<G, std::pair<std::size_t, std::size_t>> stashed_;  // run of a vertex in stash_
+        std::vector<Arc> stash_;
+    };
+
+    template<graph G, typename W>
+    using distance_t = std::invoke_result_t<W&, vertex_t<G>, vertex_t<G>>;
+
+    // the potential of Dijkstra, and the goal of searches labeling everything they reach
+    inline constexpr auto noPotential = [](const auto&) { return 0; };
+    inline constexpr auto noGoal      = [](const auto&) { return false; };
+
+    // Label setting search from all sources at distance zero until a settled vertex satisfies
+    // goal(u), which it returns. arcs(u, relax) calls relax(v, length) for every arc u -> v the
+    // search may follow, so callers can restrict, reverse or add arcs. potential(v) has to be
+    // consistent (never drop by more than an arc length), zero for Dijkstra. Vertices it rates
+    // infinitely far cannot reach the goal, they are labeled but not expanded.
+    template<graph G, typename Distance, std::ranges::input_range Sources, typename Arcs,
+             potential_function<G> P, std::predicate<const vertex_t<G>&> Goal>
+    std::optional<vertex_t<G>> search(const G& graph, Sources&& sources, Arcs arcs, P potential,
+                                      Goal goal, SearchTree<G, Distance>& tree) {
+        using Entry = SearchTree<G, Distance>::Entry;
+        // ties go to the closer vertex, then the smaller one where vertices are ordered
+        auto later = [](const Entry& a, const Entry& b) {
+            if (a.key != b.key) return a.key > b.key;
+            if (a.distance != b.distance) return a.distance > b.distance;
+            if constexpr (std::totally_ordered<vertex_t<G>>)
+                return a.vertex > b.vertex;
+            else
+                return false;
+        };
+
+        tree.clear(graph);
+        auto& labels = tree.labels();
+        auto& heap   = tree.frontier();
+        for (const vertex_t<G>& source : sources) {
+            auto [label, added] = labels.insert(source);
+            if (!added) continue;  // listed twice
+            *label = {Distance {}, source};
+            heap.push_back({static_cast<Distance>(potential(source)), Distance {}, source});
+        }
+        std::ranges::make_heap(heap, later);
+
+        while (!heap.empty()) {
+            std::ranges::pop_heap(heap, later);
+            auto [key, settled, u] = std::move(heap.back());
+            heap.pop_back();
+            if (settled > labels.find(u)->distance) continue;  // stale entry
+            if (goal(u)) return u;
+
+            arcs(u, [&](const vertex_t<G>& v, Distance length) {
+                Distance candidate  = settled + length;
+                auto [label, added] = labels.insert(v);
+                if (!added && label->distance <= candidate) return;
+                *label   = {candidate, u};
+                auto key = candidate + static_cast<Distance>(potential(v));
+                if constexpr (std::numeric_limits<Distance>::has_infinity)
+                    if (key == std::numeric_limits<Distance>::infinity()) return;
+                heap.push_back({key, candidate, v});
+                std::ranges::push_heap(heap, later);
+            });
+        }
+        return std::nullopt;
+    }
+
+    // arcs(u, relax) of search over the edges of the graph, weighted by weight(u, v)
+    template<graph G, weight_function<G> W>
+    auto weightedArcs(const G& graph, W weight) {
+        return [&graph, weight](const vertex_t<G>& u, auto&& relax) {
+            forEachNeighbour(graph, u, [&](const vertex_t<G>& v) { relax(v, weight(u, v)); });
+        };
+    }
+
+    // A* from the source until the target is settled. The potential has to be consistent (never
+    // drop by more than the edge weight), Dijkstra is the zero potential.
+    template<graph G, weight_function<G> W, potential_function<G> P>
+    void astar(const G& graph, const vertex_t<G>& source, const std::optional<vertex_t<G>>& target,
+               W weight, P potential, SearchTree<G, distance_t<G, W>>& tree) {
+        search(graph, std::views::single(source), weightedArcs(graph, weight), potential,
+               [&target](const vertex_t<G>& u) { return target && u == *target; }, tree);
+    }
+
+    template<graph G, weight_function<G> W, potential_function<G> P>
+    SearchTree<G, distance_t<G, W>> astar(const G& graph, const vertex_t<G>& source,
+                                          const std::optional<vertex_t<G>>& target, W weight,
+                                          P potential) {
+        SearchTree<G, distance_t<G, W>> tree;
+        astar(graph, source, target, weight, potential, tree);
+        return tree;
+    }
+
+    // Shortest paths from the source, all reachable vertices unless a target ends the search.
+    template<graph G, weight_function<G> W>
+    void dijkstra(const G& graph, const vertex_t<G>& source, W weight,
+                  const std::optional<vertex_t<G>>& target, SearchTree<G, distance_t<G, W>>& tree) {
+        astar(graph, source, target, weight, noPotential, tree);
+    }
+
+    template<graph G, weight_function<G> W>
+    SearchTree<G, distance_t<G, W>> dijkstra(const G& graph, const vertex_t<G>& source, W weight,
+                                             const std::optional<vertex_t<G>>& target = {}) {
+        SearchTree<G, distance_t<G, W>> tree;
+        dijkstra(graph, source, weight, target, tree);
+        return tree;
+    }
+
+    // Dijkstra from the source under two weightings of the same arcs, each until it settles the
+    // target. arcs(u, visit) calls visit(v, lengths) for every arc u -> v, lengths() weighs it
+    // both ways. The first search weighs the arcs of the vertices it expands both ways at once and
+    // stashes them with their second length. The second search relaxes those from the stash, it
+    // walks adjacency and fetches what the lengths come from only for vertices the first one did
+    // not expand. Both run on search(), the trees are the ones dijkstra() builds per weighting.
+    template<graph G, typename Distance, typename Arcs>
+    void dualDijkstra(const G& graph, const vertex_t<G>& source, const vertex_t<G>& target,
+                      Arcs arcs, DualSearchTree<G, Distance>& trees) {
+        auto& stash   = trees.stash();
+        auto& stashed = trees.stashed();
+        auto isTarget = [&target](const vertex_t<G>& u) { return u == target; };
+        trees.clear(graph);
+
+        auto weighBoth = [&](const vertex_t<G>& u, auto&& relax) {
+            auto first = stash.size();
+            arcs(u, [&](const vertex_t<G>& v, auto&& lengths) {
+                auto [length, second] = lengths();
+                relax(v, length);
+                stash.emplace_back(v, second);
+            });
+            *stashed.insert(u).first = {first, stash.size()};
+        };
+        search(graph, std::views::single(source), weighBoth, noPotential, isTarget, trees[0]);
+
+        auto readBack = [&](const vertex_t<G>& u, auto&& relax) {
+            if (auto run = stashed.find(u))
+                for (auto k = run->first; k < run->second; k++)
+                    relax(stash[k].first, stash[k].second);
+            else
+                arcs(u, [&](const vertex_t<G>& v, auto&& lengths) { relax(v, lengths().second); });
+        };
+        search(graph, std::views::single(source), readBack, noPotential, isTarget, trees[1]);
+    }
+
+    // Fewest hops from the source, every reachable vertex unless a target ends the search.
+    template<graph G>
+    SearchTree<G, std::size_t> bfs(const G& graph, const vertex_t<G>& source,
+                                   const std::optional<vertex_t<G>>& target = {}) {
+        SearchTree<G, std::size_t> tree(graph);
+        auto& labels = tree.labels();
+        std::deque<vertex_t<G>> queue {source};
+        labels[source] = {0, source};
+        while (!queue.empty() && !(target && labels.find(*target))) {
+            auto u    = std::move(queue.front());
+            auto hops = labels.find(u)->distance + 1;
+            queue.pop_front();
+            forEachNeighbour(graph, u, [&](const vertex_t<G>& v) {
+                if (auto [label, added] = labels.insert(v); added) {
+                    *label = {hops, u};
+                    queue.push_back(v);
+                }
+            });
+        }
+        return tree;
+    }
+
+    // Strongly connected components (Tarjan, with an explicit stack instead of recursion).
+    // Components come in reverse topological order of the condensation.
+    template<graph G>
+    std::vector<std::vector<vertex_t<G>>> stronglyConnectedComponents(const G& graph) {
+        using Vertex   = vertex_t<G>;
+        using Iterator = std::ranges::iterator_t<decltype(graph.adjacent(std::declval<Vertex>()))>;
+        struct Mark {
+            std::size_t index, lowlink;
+            bool onStack;
+        };
+        struct Frame {
+            Vertex vertex;
+            Iterator next;
+        };
+
+        std::vector<std::vector<Vertex>> components;
+        VertexMap<G, Mark> marks(graph);
+        std::vector<Vertex> stack;
+        std::vector<Frame> calls;
+        std::size_t counter {};
+
+        auto enter = [&](const Vertex& v) {
+            marks[v] = {counter, counter, true};
+            counter++;
+            stack.push_back(v);
+            calls.push_back({v, std::ranges::begin(graph.adjacent(v))});
+        };
+
+        for (const Vertex& root : graph.vertices()) {
+            if (marks.find(root)) continue;
+            enter(root);
+            while (!calls.empty()) {
+                auto& frame = calls.back();
+                auto& mark  = *marks.find(frame.vertex);
+                if (frame.next != std::ranges::end(graph.adjacent(frame.vertex))) {
+                    const Vertex& w = *frame.next++;
+                    if (auto other = marks.find(w); !other)
+                        enter(w);  // invalidates frame and mark
+                    else if (other->onStack)
+                        mark.lowlink = std::min(mark.lowlink, other->index);
+                    continue;
+                }
+
+                auto v = frame.vertex;
+                calls.pop_back();
+                if (!calls.empty()) {
+                    auto& caller   = *marks.find(calls.back().vertex);
+                    caller.lowlink = std::min(caller.lowlink, mark.lowlink);
+                }
+                if (mark.lowlink != mark.index) continue;
+
+                auto& component = components.emplace_back();
+                do {
+                    component.push_back(stack.back());
+                    marks.find(stack.back())->onStack = false;
+                    stack.pop_back();
+                } while (component.back() != v);
+            }
+        }
+        return components;
+    }
+
+}  // namespace graphs
\ No newline at end of file
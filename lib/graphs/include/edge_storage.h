@@ -0,0 +1,290 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <vector>
+
+namespace graphs::storage
+{
+
+    // What GraphBase needs from the edge list of a vertex.
+    template<typename S>
+    concept edge_storage = std::default_initializable<S>
+                           && requires(S s, const S cs, const typename S::value_type& key) {
+                                  { s.insert(key) } -> std::same_as<bool>;
+                                  { s.erase(key) } -> std::same_as<typename S::size_type>;
+                                  { cs.contains(key) } -> std::same_as<bool>;
+                                  { cs.size() } -> std::same_as<typename S::size_type>;
+                                  { cs.empty() } -> std::same_as<bool>;
+                                  { cs.begin() } -> std::forward_iterator;
+                                  { cs.end() } -> std::forward_iterator;
+                                  s.clear();
+                              };
+
+    // Insertion order, O(1) insert keeping duplicates, linear lookup and erase.
+    template<typename Key>
+    class UnsortedVector {
+    public:
+        using value_type     = Key;
+        using size_type      = std::vector<Key>::size_type;
+        using const_iterator = std::vector<Key>::const_iterator;
+
+        bool insert(const Key& key) {
+            edges_.push_back(key);
+            return true;
+        }
+
+        size_type erase(const Key& key) { return std::erase(edges_, key); }
+
+        bool contains(const Key& key) const {
+            return std::ranges::find(edges_, key) != edges_.end();
+        }
+
+        size_type size() const noexcept { return edges_.size(); }
+
+        bool empty() const noexcept { return edges_.empty(); }
+
+        void clear() noexcept { edges_.clear(); }
+
+        const_iterator begin() const noexcept { return edges_.begin(); }
+
+        const_iterator end() const noexcept { return edges_.end(); }
+
+    private:
+        std::vector<Key> edges_;
+    };
+
+    // Ascending keys without duplicates, binary search lookup, linear insert and erase.
+    template<typename Key, typename Compare = std::less<Key>>
+    class SortedVector {
+    public:
+        using value_type     = Key;
+        using size_type      = std::vector<Key>::size_type;
+        using const_iterator = std::vector<Key>::const_iterator;
+
+        bool insert(const Key& key) {
+            auto it = std::ranges::lower_bound(edges_, key, compare_);
+            if (it != edges_.end() && !compare_(key, *it)) return false;
+            edges_.insert(it, key);
+            return true;
+        }
+
+        size_type erase(const Key& key) {
+            auto it = std::ranges::lower_bound(edges_, key, compare_);
+            if (it == edges_.end() || compare_(key, *it)) return 0;
+            edges_.erase(it);
+            return 1;
+        }
+
+        bool contains(const Key& key) const {
+            return std::ranges::binary_search(edges_, key, compare_);
+        }
+
+        size_type size() const noexcept { return edges_.size(); }
+
+        bool empty() const noexcept { return edges_.empty(); }
+
+        void clear() noexcept { edges_.clear(); }
+
+        const_iterator begin() const noexcept { return edges_.begin(); }
+
+        const_iterator end() const noexcept { return edges_.end(); }
+
+    private:
+        std::vector<Key> edges_;
+        [[no_unique_address]] Compare compare_;
+    };
+
+    // Up to N keys inline in the vertex without a heap allocation, spilling to the heap beyond.
+    // No duplicates, linear lookup, which is the fastest there is over a handful of keys.
+    template<typename Key, std::size_t N>
+    class BasicSmallVector {
+    public:
+        using value_type     = Key;
+        using size_type      = std::size_t;
+        using const_iterator = const Key*;
+
+        bool insert(const Key& key) {
+            if (contains(key)) return false;
+            if (size_ < N)
+                inline_[size_] = key;
+            else {
+                if (size_ == N) heap_.assign(inline_.begin(), inline_.end());
+                heap_.push_back(key);
+            }
+            size_++;
+            return true;
+        }
+
+        size_type erase(const Key& key) {
+            auto index = std::find(begin(), end(), key) - begin();
+            if (index == static_cast<std::ptrdiff_t>(size_)) return 0;
+            if (size_ > N) {
+                heap_.erase(heap_.begin() + index);
+                if (heap_.size() == N) {  // back inline
+                    std::ranges::move(heap_, inline_.begin());
+                    heap_.clear();
+                }
+            }
+            else {
+                auto first = inline_.begin() + index;
+                std::move(first + 1, inline_.begin() + size_, first);
+                inline_[size_ - 1] = Key();
+            }
+            size_--;
+            return 1;
+        }
+
+        bool contains(const Key& key) const { return std::find(begin(), end(), key) != end(); }
+
+        size_type size() const noexcept { return size_; }
+
+        bool empty() const noexcept { return size_ == 0; }
+
+        void clear() noexcept {
+            std::ranges::fill(inline_, Key());
+            heap_.clear();
+            size_ = 0;
+        }
+
+        const_iterator begin() const noexcept { return size_ > N ? heap_.data() : inline_.data(); }
+
+        const_iterator end() const noexcept { return begin() + size_; }
+
+    private:
+        std::array<Key, N> inline_ {};
+        std::vector<Key> heap_;  // all keys once there are more than N
+        size_type size_ {};
+    };
+
+    // an EdgeStorage takes type parameters only, the inline capacity is fixed here
+    template<typename Key>
+    using SmallVector = BasicSmallVector<Key, 8>;
+
+    // Open addressing with linear probing and backward shift deletion (no tombstones), O(1)
+    // lookup and erase for vertices of high degree. Iterates in no particular order.
+    template<typename Key, typename Hash = std::hash<Key>, typename Equal = std::equal_to<Key>>
+    class FlatHashSet {
+        using slot = std::optional<Key>;
+
+    public:
+        using value_type = Key;
+        using size_type  = std::size_t;
+
+        class const_iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = Key;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = const Key*;
+            using reference         = const Key&;
+
+            const_iterator() = default;
+
+            const_iterator(const slot* it, const slot* end)
+                : it_(it), end_(end) {
+                skip();
+            }
+
+            reference operator*() const { return **it_; }
+
+            pointer operator->() const { return &**it_; }
+
+            const_iterator& operator++() {
+                ++it_;
+                skip();
+                return *this;
+            }
+
+            const_iterator operator++(int) {
+                auto copy = *this;
+                ++*this;
+                return copy;
+            }
+
+            bool operator==(const const_iterator& other) const { return it_ == other.it_; }
+
+        private:
+            void skip() {
+                while (it_ != end_ && !*it_)
+                    ++it_;
+            }
+
+            const slot* it_ {};
+            const slot* end_ {};
+        };
+
+        bool insert(const Key& key) {
+            if ((size_ + 1) * 4 > slots_.size() * 3) grow();
+            auto& target = slots_[probe(key)];
+            if (target) return false;
+            target.emplace(key);
+            size_++;
+            return true;
+        }
+
+        size_type erase(const Key& key) {
+            if (empty()) return 0;
+            auto hole = probe(key);
+            if (!slots_[hole]) return 0;
+
+            // pull back later keys of the run whose probe sequence passes over the hole
+            auto mask = slots_.size() - 1;
+            for (auto i = (hole + 1) & mask; slots_[i]; i = (i + 1) & mask) {
+                auto home = hash_(*slots_[i]) & mask;
+                if (((i - home) & mask) >= ((i - hole) & mask)) {
+                    slots_[hole] = std::move(slots_[i]);
+                    hole         = i;
+                }
+            }
+            slots_[hole].reset();
+            size_--;
+            return 1;
+        }
+
+        bool contains(const Key& key) const { return !empty() && slots_[probe(key)].has_value(); }
+
+        size_type size() const noexcept { return size_; }
+
+        bool empty() const noexcept { return size_ == 0; }
+
+        void clear() noexcept {
+            slots_.clear();
+            size_ = 0;
+        }
+
+        const_iterator begin() const noexcept {
+            return {slots_.data(), slots_.data() + slots_.size()};
+        }
+
+        const_iterator end() const noexcept {
+            return {slots_.data() + slots_.size(), slots_.data() + slots_.size()};
+        }
+
+    private:
+        // slot holding the key, or the empty one ending its run
+        size_type probe(const Key& key) const {
+            auto mask = slots_.size() - 1;
+            for (auto i = hash_(key) & mask;; i = (i + 1) & mask)
+                if (!slots_[i] || equal_(*slots_[i], key)) return i;
+        }
+
+        void grow() {
+            std::vector<slot> old(std::max<size_type>(8, slots_.size() * 2));
+            old.swap(slots_);
+            for (auto& key : old)
+                if (key) slots_[probe(*key)] = std::move(key);
+        }
+
+        std::vector<slot> slots_;  // capacity is a power of two
+        size_type size_ {};
+        [[no_unique_address]] Hash hash_;
+        [[no_unique_address]] Equal equal_;
+    };
+
+}  // namespace graphs::storage
\ No newline at end of file
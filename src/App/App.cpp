@@ -1,12 +1,36 @@
 #include "App.h"
 
+#include <algorithm>
+#include <future>
+#include <iterator>
 #include <iostream>
 
+#include "DeltaStepping.h"
 #include "FileHandler.h"
+#include "Overlay.h"
+#include "ShortestPathTrees.h"
 #include "config.h"
 
 using namespace citymap;
 
+static inline VertexOrder vertexOrderOf(std::string_view name) {
+    if (name == "hilbert") return VertexOrder::Hilbert;
+    if (name == "bfs") return VertexOrder::Bfs;
+    if (name == "rcm") return VertexOrder::Rcm;
+    return VertexOrder::Input;
+}
+
+static inline AdjacencyLayout adjacencyLayoutOf(std::string_view name) {
+    return name == "packed" ? AdjacencyLayout::Packed : AdjacencyLayout::Plain;
+}
+
+static inline std::string describeQuery(const UnifiedQuery& query, const Map& map) {
+    if (query.nearest() == Map::ncat) return map.describe(query.get().stops(), " -> ");
+    auto from = query.from() == Map::npnt ? std::string("*")
+                                          : std::string(map.nameOf(query.from()));
+    return from + " -> nearest:" + map.categoryName(query.nearest());
+}
+
 static inline void initCliOptions(CLI::clipper& c, App::CliOptions& o) {
     // clang-format off
     c.name(PROJECT_NAME).author(PROJECT_AUTHOR);
@@ -27,18 +51,97 @@ static inline void initCliOptions(CLI::clipper& c, App::CliOptions& o) {
 
     c.add_option<std::filesystem::path>("-q")
         .set("file", o.queriesFile)
-        .doc("Input with path queries")
-        .req();
+        .doc("Input with path queries (required unless --serve or --isochrones is used)");
+
+    c.add_option<std::filesystem::path>("--isochrones")
+        .set("file", o.isochronesFile)
+        .doc("Input with '<centre> <distance>' lines, writes every point reachable within it.");
 
     c.add_option<std::filesystem::path>("-out")
         .set("file", o.outputFile)
-        .doc("Output file")
-        .req();
+        .doc("Output file (required unless --serve is used)");
+
+    c.add_option<std::string>("--out-format")
+        .set("format", o.outFormat, "text")
+        .doc("Writes routes as text, or bin for a memory-mappable binary file, defaults to text.")
+        .match("text", "bin");
 
     c.add_option<std::string>("--type", "-t")
         .set("type", o.type, "Both")
         .doc("Sets the output type for queries, defaults to both.")
         .match("Pedestrian", "Car", "Both");
+
+    c.add_option<std::size_t>("--alternatives", "-k")
+        .set("count", o.alternatives, std::size_t {1})
+        .doc("Writes up to this many loopless routes per query, shortest first, defaults to 1.");
+
+    c.add_flag("--hops")
+        .set(o.hops)
+        .doc("Routes queries through the fewest intersections instead of the shortest distance.");
+
+    c.add_flag("--distances")
+        .set(o.distances)
+        .doc("Writes only the distance of each query, looked up in hub labels of the map.");
+
+    c.add_option<std::filesystem::path>("--hub-labels")
+        .set("file", o.hubLabelsFile)
+        .doc("Loads the hub labels of --distances from this file, or computes and saves them"
+             " there when it is stale. Without it they are computed in memory only.");
+
+    c.add_flag("--lazy")
+        .set(o.lazy)
+        .doc("Parses connection rows only when a search reaches them, for a few queries on a huge"
+             " matrix.");
+
+    c.add_option<std::string>("--order")
+        .set("order", o.order, "input")
+        .doc("Memory layout of the road network used by searches, defaults to input (ascending"
+             " point id) order.")
+        .match("input", "hilbert", "bfs", "rcm");
+
+    c.add_option<std::string>("--adjacency")
+        .set("layout", o.adjacency, "plain")
+        .doc("Storage of the road network arcs: plain or packed (delta + varint, decoded by every"
+             " search). Packed needs less than half the memory with --order hilbert, but searches"
+             " run slower unless the map is far larger than the cache.")
+        .match("plain", "packed");
+
+    c.add_option<std::size_t>("--landmarks")
+        .set("count", o.landmarks, std::size_t {})
+        .doc("Speeds up queries with A* over this many landmarks (ALT), disabled by default.");
+
+    c.add_option<std::filesystem::path>("--landmarks-file")
+        .set("file", o.landmarksFile)
+        .doc("Loads landmarks from this file, or computes and saves them there when it is stale.");
+
+    c.add_flag("--overlay")
+        .set(o.overlay)
+        .doc("Answers queries over a customized multi-level overlay of the map (CRP).");
+
+    c.add_option<std::string>("--depots")
+        .set("category", o.depots)
+        .doc("Keeps the shortest path trees of every point of this category, routes from them are"
+             " read off the trees, which --serve updates repair instead of searching again.");
+
+    c.add_option<std::filesystem::path>("--trace")
+        .set("file", o.traceFile)
+        .doc("Writes phase and query timings as a Chrome trace (JSON) and prints a summary.");
+
+    c.add_flag("--serve")
+        .set(o.serve)
+        .doc("Keeps the map loaded and answers '<from> <to> [type]' lines on stdin/stdout.");
+
+    c.add_option<std::filesystem::path>("--socket")
+        .set("file", o.socketFile)
+        .doc("With --serve, also accepts clients on this unix domain socket.");
+
+    c.add_option<unsigned>("--threads", "-j")
+        .set("count", o.threads, 0u)
+        .doc("Worker threads used for loading and by --serve, defaults to the number of cores.");
+
+    c.add_option<std::size_t>("--cache")
+        .set("entries", o.cacheSize, std::size_t {})
+        .doc("Caches up to this many resolved routes (LRU), disabled by default.");
     // clang-format on
 }
 
@@ -55,49 +158,329 @@ int App::run() {
     EXIT_ON_FAIL;
     loadInputs();
     EXIT_ON_FAIL;
+    prepareLandmarks();
+    EXIT_ON_FAIL;
+    prepareOverlay();
+    prepareShortestPathTrees();
+    EXIT_ON_FAIL;
+    prepareHubLabels();
+    EXIT_ON_FAIL;
+    if (options_.serve) {
+        serve();
+        EXIT_ON_FAIL;
+        writeTrace();
+        return static_cast<int>(state_);
+    }
     resolveQueries();
+    EXIT_ON_FAIL;
+    resolveIsochrones();
     writeOutput();
     EXIT_ON_FAIL;
+    writeTrace();
+    EXIT_ON_FAIL;
     return 0;  // exit success
 }
 
 inline void App::loadInputs() {
-    fileHandler_.loadCoordinates(options_.coordsFile, map_);
-    fileHandler_.loadConnections(options_.connectFile, map_);
+    auto span = tracer_.span("loadInputs");
+    pool_     = std::make_unique<ThreadPool>(options_.threads);
+
+    // in server mode queries arrive through the server
+    FileHandler::InputFiles files {options_.coordsFile, options_.connectFile,
+                                   options_.serve ? std::filesystem::path() : options_.queriesFile};
 
-    if (options_.type == "Pedestrian")
-        fileHandler_.loadQueries(options_.queriesFile, queries_, PathType::Pedestrian, map_);
+    auto type = options_.type == "Pedestrian" ? PathType::Pedestrian : PathType::Car;
+    if (options_.lazy) {
+        fileHandler_.loadCoordinates(options_.coordsFile, map_);
+        fileHandler_.loadLazyConnections(options_.connectFile, lazy_, map_);
+        fileHandler_.loadQueries(options_.queriesFile, queries_, type, map_);
+    }
     else
-        fileHandler_.loadQueries(options_.queriesFile, queries_, PathType::Car, map_);
+        fileHandler_.loadInputs(files, map_, queries_, type, *pool_, tracer_);
+
+    if (!options_.isochronesFile.empty())
+        fileHandler_.loadIsochrones(options_.isochronesFile, isochrones_, type, map_);
+
+    if (fileHandler_.fail()) {
+        std::cerr << fileHandler_.error() << '\n';
+        state_ = State::loading_error;
+        return;
+    }
+    mapArena_.seal();   // connections changed later, e.g. by --serve updates, are freed again
+    if (lazy_) return;  // searches run on the matrix itself
 
+    auto layout = tracer_.span("layoutMap");
+    map_.layout(vertexOrderOf(options_.order));
+    map_.adjacency(adjacencyLayoutOf(options_.adjacency));
+    map_.compact();  // built up front instead of by the first query
+}
+
+inline void App::prepareLandmarks() {
+    if (!options_.landmarks && options_.landmarksFile.empty()) return;
+    auto span      = tracer_.span("prepareLandmarks");
+    auto graph     = map_.compact();
+    auto landmarks = std::make_shared<Landmarks>();
+
+    if (std::filesystem::exists(options_.landmarksFile)) {
+        fileHandler_.loadLandmarks(options_.landmarksFile, *graph, *landmarks);
+        if (fileHandler_.fail()) {
+            std::clog << fileHandler_.error() << " Recomputing.\n";
+            fileHandler_.clear();
+        }
+    }
+    if (landmarks->empty()) {
+        auto count = options_.landmarks ? options_.landmarks : Landmarks::defaultCount;
+        *landmarks = Landmarks(*graph, count, pool_.get());
+        if (!options_.landmarksFile.empty())
+            fileHandler_.writeLandmarks(options_.landmarksFile, *graph, *landmarks);
+    }
     if (fileHandler_.fail()) {
         std::cerr << fileHandler_.error() << '\n';
+        state_ = State::writing_error;
+        return;
+    }
+    map_.landmarks(std::move(landmarks));
+}
+
+inline void App::prepareOverlay() {
+    if (!options_.overlay) return;
+    auto span = tracer_.span("prepareOverlay");
+    map_.overlay(std::make_shared<Overlay>(*map_.compact(), pool_.get()));
+}
+
+inline void App::prepareShortestPathTrees() {
+    if (options_.depots.empty()) return;
+    auto span     = tracer_.span("prepareShortestPathTrees");
+    auto category = map_.findCategory(options_.depots);
+    if (category == Map::ncat) {
+        std::cerr << "Unknown --depots category: " << options_.depots << '\n';
         state_ = State::loading_error;
+        return;
     }
+    auto graph = map_.compact();
+    std::vector<CompactGraph::Vertex> sources;
+    for (auto id : map_.facilities(category))
+        sources.push_back(graph->vertexOf(id));
+    map_.shortestPathTrees(std::make_shared<ShortestPathTrees>(*graph, sources, pool_.get()));
+}
+
+// Loaded from --hub-labels, or computed and saved there when missing or stale.
+inline void App::prepareHubLabels() {
+    if (!options_.distances) return;
+    auto span   = tracer_.span("prepareHubLabels");
+    auto graph  = map_.compact();
+    auto labels = std::make_shared<HubLabels>();
+
+    if (std::filesystem::exists(options_.hubLabelsFile)) {
+        fileHandler_.loadHubLabels(options_.hubLabelsFile, *graph, *labels);
+        if (fileHandler_.fail()) {
+            std::clog << fileHandler_.error() << " Recomputing.\n";
+            fileHandler_.clear();
+        }
+    }
+    if (labels->empty() && graph->size()) {
+        *labels = HubLabels(*graph, pool_.get());
+        if (!options_.hubLabelsFile.empty())
+            fileHandler_.writeHubLabels(options_.hubLabelsFile, *graph, *labels);
+    }
+    if (fileHandler_.fail()) {
+        std::cerr << fileHandler_.error() << '\n';
+        state_ = State::writing_error;
+        return;
+    }
+    map_.hubLabels(std::move(labels));
 }
 
 inline void App::resolveQueries() {
-    if (options_.type == "Both")
-        resolveQueriesBoth();
-    else
-        resolveQueriesSpecific();
+    auto span = tracer_.span("resolveQueries");
+    try {
+        if (options_.hops)
+            resolveHopQueries();
+        else if (options_.distances)
+            resolveDistances();
+        else if (options_.type == "Both")
+            resolveQueriesBoth();
+        else
+            resolveQueriesSpecific();
+    }
+    catch (const std::exception& e) {  // a malformed --lazy row or a query the mode cannot answer
+        std::cerr << e.what() << '\n';
+        state_ = State::loading_error;
+    }
 }
 
+// Both routes of a query come from one fused search unless it is answered per type anyway.
 inline void App::resolveQueriesBoth() {
     for (auto& query : queries_) {
-        foundPaths_.emplace_back(map_.findPath(query));
+        if (lazy_ || cache_ || options_.alternatives > 1 || query.from() == Map::npnt) {
+            resolveQuery(query);
+            query.toggleType();
+            resolveQuery(query);
+            continue;
+        }
+        auto begin = Tracer::Clock::now();
+        std::ranges::move(map_.findBothPaths(query, pool_.get(), &batchArena_),
+                          std::back_inserter(foundPaths_));
+        auto end = Tracer::Clock::now();  // both routes took the one search
+        if (tracer_.enabled())
+            tracer_.recordQuery(query.type(), begin, end, describeQuery(query, map_));
         query.toggleType();
-        foundPaths_.emplace_back(map_.findPath(query));
+        if (tracer_.enabled())
+            tracer_.recordQuery(query.type(), begin, end, describeQuery(query, map_));
     }
 }
 
 inline void App::resolveQueriesSpecific() {
     for (auto& query : queries_)
-        foundPaths_.emplace_back(map_.findPath(query));
+        resolveQuery(query);
+}
+
+// '* nearest:<category>' routes every point to its closest facility in a single search
+inline void App::resolveQuery(const UnifiedQuery& query) {
+    auto begin = Tracer::Clock::now();
+    if (lazy_)
+        foundPaths_.push_back(lazy_->findPath(query));
+    else if (query.nearest() != Map::ncat && query.from() == Map::npnt)
+        std::ranges::move(map_.findNearest(query.nearest(), query.type(), &batchArena_),
+                          std::back_inserter(foundPaths_));
+    else if (options_.alternatives > 1)
+        std::ranges::move(map_.findAlternatives(query, options_.alternatives, &batchArena_),
+                          std::back_inserter(foundPaths_));
+    else
+        foundPaths_.emplace_back(cache_ ? cache_->findPath(map_, query, pool_.get(), &batchArena_)
+                                        : map_.findPath(query, pool_.get(), &batchArena_));
+    if (tracer_.enabled())
+        tracer_.recordQuery(query.type(), begin, Tracer::Clock::now(), describeQuery(query, map_));
+}
+
+// A query the mode cannot answer is left out of the output, the others are still resolved.
+inline void App::reportSkipped(const UnifiedQuery& query, std::string_view reason) const {
+    std::cerr << "Skipped query " << describeQuery(query, map_) << ": " << reason << '\n';
+}
+
+// All legs are routed over one bit matrix of the map, built once for the whole batch.
+inline void App::resolveHopQueries() {
+    std::vector<std::pair<PointId, PointId>> legs;
+    for (auto& query : queries_) {
+        if (query.nearest() != Map::ncat) {
+            reportSkipped(query, "--hops only routes between points");
+            continue;
+        }
+        auto stops = query.get().stops();
+        for (std::size_t i = 0; i + 1 < stops.size(); i++)
+            legs.emplace_back(stops[i], stops[i + 1]);
+    }
+    auto routes = map_.findFewestHops(legs);
+
+    auto leg = routes.begin();
+    for (auto& query : queries_) {
+        if (query.nearest() != Map::ncat) continue;
+        auto& route = hopRoutes_.emplace_back();
+        for (std::size_t i = 0; i <= query.via().size(); i++, leg++) {
+            if (leg->empty() || (i && route.empty())) {  // a leg is unreachable
+                route.clear();
+                continue;
+            }
+            route.insert(route.end(), leg->begin() + (i ? 1 : 0), leg->end());
+        }
+    }
+}
+
+// Distance of every query, of both types one after the other when Both.
+inline void App::resolveDistances() {
+    for (auto query : queries_) {
+        if (query.nearest() != Map::ncat) {
+            reportSkipped(query, "--distances only go between points");
+            continue;
+        }
+        for (int pass = options_.type == "Both" ? 2 : 1; pass > 0; pass--) {
+            auto begin = Tracer::Clock::now();
+            distances_.emplace_back(query, map_.findDistance(query));
+            if (tracer_.enabled())
+                tracer_.recordQuery(query.type(), begin, Tracer::Clock::now(),
+                                    describeQuery(query, map_));
+            query.toggleType();
+        }
+    }
+}
+
+// Centres are independent bounded searches, resolved in parallel on the pool.
+inline void App::resolveIsochrones() {
+    if (isochrones_.empty()) return;
+    auto span = tracer_.span("resolveIsochrones");
+    if (options_.type == "Both") {  // Car then Pedestrian, like the routes
+        std::vector<Isochrone> both;
+        both.reserve(isochrones_.size() * 2);
+        for (auto& isochrone : isochrones_) {
+            both.emplace_back(isochrone.centre(), isochrone.budget(), PathType::Car);
+            both.emplace_back(isochrone.centre(), isochrone.budget(), PathType::Pedestrian);
+        }
+        isochrones_ = std::move(both);
+    }
+
+    // too few to keep the workers busy on their own, each is spread over the pool instead
+    if (isochrones_.size() < pool_->size() && DeltaStepping::pays(*map_.compact(), pool_.get())) {
+        for (auto& isochrone : isochrones_)
+            isochrone = map_.isochrone(isochrone.centre(), isochrone.budget(), isochrone.type(),
+                                       pool_.get());
+        return;
+    }
+    std::vector<std::future<void>> tasks;
+    tasks.reserve(isochrones_.size());
+    for (auto& isochrone : isochrones_) {
+        tasks.push_back(pool_->submit([this, &isochrone] {
+            isochrone = map_.isochrone(isochrone.centre(), isochrone.budget(), isochrone.type());
+        }));
+    }
+    for (auto& task : tasks)
+        task.get();
+}
+
+inline void App::serve() {
+    auto span = tracer_.span("serve");
+    Server server(map_, *pool_, tracer_, cache_.get());
+    server.defaultType(options_.type);
+    if (!options_.socketFile.empty()) server.listen(options_.socketFile);
+
+    if (server.fail()) {
+        std::cerr << server.error() << '\n';
+        state_ = State::serving_error;
+        return;
+    }
+    server.run();
 }
 
 inline void App::writeOutput() {
-    fileHandler_.writeOutput(options_.outputFile, foundPaths_, map_);
+    auto span = tracer_.span("writeOutput");
+    if (options_.distances)
+        fileHandler_.writeDistances(options_.outputFile, distances_, map_);
+    else if (options_.outFormat == "bin")
+        fileHandler_.writeBinaryOutput(options_.outputFile, foundPaths_, map_);
+    else if (!options_.queriesFile.empty())
+        fileHandler_.writeOutput(options_.outputFile, foundPaths_, map_);
+    if (options_.hops) fileHandler_.writeHopRoutes(options_.outputFile, hopRoutes_, map_, true);
+    if (!options_.isochronesFile.empty())
+        fileHandler_.writeIsochrones(options_.outputFile, isochrones_, map_,
+                                     !options_.queriesFile.empty());
+    if (fileHandler_.fail()) {
+        std::cerr << fileHandler_.error() << '\n';
+        state_ = State::writing_error;
+    }
+}
+
+inline void App::writeTrace() {
+    if (!tracer_.enabled()) return;
+    tracer_.summary(std::clog);
+    if (cache_) {
+        auto stats = cache_->stats();
+        std::clog << "Route cache: " << stats.hits << " hits, " << stats.misses << " misses, "
+                  << stats.evictions << " evictions, " << stats.invalidations
+                  << " invalidations\n";
+    }
+    if (lazy_)
+        std::clog << "Lazy matrix: " << lazy_->decoded() << " of " << lazy_->rows()
+                  << " rows parsed\n";
+    fileHandler_.writeTrace(options_.traceFile, tracer_);
     if (fileHandler_.fail()) {
         std::cerr << fileHandler_.error() << '\n';
         state_ = State::writing_error;
@@ -105,14 +488,52 @@ inline void App::writeOutput() {
 }
 
 inline void App::handleCli() {
+    auto span = tracer_.span("handleCli");
     if (!cli_.parse(argc_, argv_)) {
         state_ = State::cli_error;
         for (auto& i : cli_.wrong())
             std::cerr << i << '\n';
     }
+    else if (!options_.serve
+             and ((options_.queriesFile.empty() and options_.isochronesFile.empty())
+                  or options_.outputFile.empty()))
+    {
+        state_ = State::cli_error;
+        std::cerr << "Missing required argument(s) -q (or --isochrones) and -out"
+                     " (or use --serve)\n";
+    }
+    else if (options_.lazy
+             and (options_.serve or options_.overlay or options_.landmarks or options_.hops
+                  or !options_.landmarksFile.empty() or !options_.isochronesFile.empty()
+                  or options_.alternatives > 1 or options_.distances or !options_.depots.empty()))
+    {
+        state_ = State::cli_error;
+        std::cerr << "--lazy only answers -q route queries, it cannot be combined with --serve,"
+                     " --overlay, --landmarks, --hops, --isochrones, --alternatives, --distances"
+                     " or --depots\n";
+    }
+    else if (options_.distances
+             and (options_.serve or options_.queriesFile.empty() or options_.hops
+                  or options_.outFormat == "bin" or options_.alternatives > 1))
+    {
+        state_ = State::cli_error;
+        std::cerr << "--distances only answers -q queries as text, it cannot be combined with"
+                     " --serve, --hops, --out-format bin or --alternatives\n";
+    }
+    else if (options_.outFormat == "bin"
+             and (options_.queriesFile.empty() or options_.hops
+                  or !options_.isochronesFile.empty()))
+    {
+        state_ = State::cli_error;
+        std::cerr << "--out-format bin only writes -q routes, it cannot be combined with --hops or"
+                     " --isochrones\n";
+    }
 
     if (options_.help or cli_.no_args()) {
         std::cout << cli_.make_help();
         state_ = State::cli_help;
     }
+
+    tracer_.enable(!options_.traceFile.empty());
+    if (options_.cacheSize) cache_ = std::make_unique<RouteCache>(options_.cacheSize);
 }
\ No newline at end of file
@@ -1,12 +1,26 @@
 #pragma once
 
 #include <filesystem>
+#include <memory>
+#include <memory_resource>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
+#include "Arena.h"
 #include "FileHandler.h"
+#include "HubLabels.h"
+#include "Isochrone.h"
+#include "Landmarks.h"
+#include "LazyGraph.h"
 #include "Map.h"
 #include "Path.h"
 #include "Query.h"
+#include "RouteCache.h"
+#include "Server.h"
+#include "ThreadPool.h"
+#include "Tracer.h"
 #include "clipper.hpp"
 
 namespace citymap
@@ -16,11 +30,29 @@ namespace citymap
     public:
         struct CliOptions {
             bool help;
+            bool serve;
+            bool overlay;
+            bool lazy;
+            bool hops;
+            bool distances;
+            unsigned threads;
+            std::size_t cacheSize;
+            std::size_t landmarks;
+            std::size_t alternatives;
             std::string type;
+            std::string order;
+            std::string adjacency;
+            std::string depots;
+            std::string outFormat;
             std::filesystem::path coordsFile;
             std::filesystem::path connectFile;
             std::filesystem::path queriesFile;
+            std::filesystem::path isochronesFile;
             std::filesystem::path outputFile;
+            std::filesystem::path traceFile;
+            std::filesystem::path socketFile;
+            std::filesystem::path landmarksFile;
+            std::filesystem::path hubLabelsFile;
         };
 
         App(CLI::arg_count, CLI::args);
@@ -34,14 +66,26 @@ namespace citymap
             cli_error,
             loading_error,
             writing_error,
+            serving_error,
         };
 
         inline void handleCli();
         inline void loadInputs();
+        inline void prepareLandmarks();
+        inline void prepareOverlay();
+        inline void prepareShortestPathTrees();
+        inline void prepareHubLabels();
         inline void resolveQueries();
         inline void resolveQueriesBoth();
         inline void resolveQueriesSpecific();
+        inline void resolveQuery(const UnifiedQuery&);
+        inline void reportSkipped(const UnifiedQuery&, std::string_view) const;
+        inline void resolveHopQueries();
+        inline void resolveDistances();
+        inline void resolveIsochrones();
+        inline void serve();
         inline void writeOutput();
+        inline void writeTrace();
 
     private:
         const CLI::arg_count argc_;
@@ -49,9 +93,18 @@ namespace citymap
         CLI::clipper cli_;
         CliOptions options_;
         FileHandler fileHandler_;
-        Map map_;
-        PolymorphicPathList foundPaths_;
+        Tracer tracer_;
+        std::unique_ptr<ThreadPool> pool_;
+        std::unique_ptr<RouteCache> cache_;
+        std::unique_ptr<LazyGraph> lazy_;
+        Arena mapArena_;                                  // what map_ allocates while loading
+        std::pmr::monotonic_buffer_resource batchArena_;  // the paths found for the queries
+        Map map_ {&mapArena_};
+        PolymorphicPathList foundPaths_ {&batchArena_};
+        std::vector<Path::PointList> hopRoutes_;
+        std::vector<std::pair<UnifiedQuery, double>> distances_;
         std::vector<UnifiedQuery> queries_;
+        std::vector<Isochrone> isochrones_;
         State state_ {};
     };
 
@@ -0,0 +1,66 @@
+#include "Arena.h"
+
+#include <algorithm>
+#include <functional>
+
+using namespace citymap;
+
+// the first block holds initialSize bytes, a default size when 0
+Arena::Arena(std::size_t initialSize, std::pmr::memory_resource* upstream)
+    : upstream_(upstream), blocks_(upstream),
+      buffer_(initialSize ? initialSize : 64 * 1024, &blocks_) {}
+
+// everything allocated in the blocks is gone, the next allocation starts a fresh block
+void Arena::release() {
+    std::scoped_lock lock(mutex_);
+    buffer_.release();
+}
+
+// Later allocations bypass the blocks. Call it while no other thread allocates.
+void Arena::seal() noexcept {
+    sealed_.store(true, std::memory_order_release);
+}
+
+bool Arena::sealed() const noexcept {
+    return sealed_.load(std::memory_order_acquire);
+}
+
+void* Arena::do_allocate(std::size_t bytes, std::size_t alignment) {
+    if (sealed()) return upstream_->allocate(bytes, alignment);
+    std::scoped_lock lock(mutex_);
+    return buffer_.allocate(bytes, alignment);
+}
+
+// blocks are not touched after sealing, so the lookup needs no lock
+void Arena::do_deallocate(void* p, std::size_t bytes, std::size_t alignment) {
+    if (sealed() && !blocks_.owns(p)) upstream_->deallocate(p, bytes, alignment);
+}
+
+bool Arena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+// a handful of geometrically growing blocks, a linear scan is enough
+bool Arena::Blocks::owns(const void* p) const noexcept {
+    auto* byte = static_cast<const std::byte*>(p);
+    return std::ranges::any_of(blocks_, [byte](auto& block) {
+        return std::less_equal<>()(block.first, byte)
+               && std::less<>()(byte, block.first + block.second);
+    });
+}
+
+void* Arena::Blocks::do_allocate(std::size_t bytes, std::size_t alignment) {
+    blocks_.reserve(blocks_.size() + 1);
+    void* p = upstream_->allocate(bytes, alignment);
+    blocks_.emplace_back(static_cast<const std::byte*>(p), bytes);
+    return p;
+}
+
+void Arena::Blocks::do_deallocate(void* p, std::size_t bytes, std::size_t alignment) {
+    std::erase_if(blocks_, [p](auto& block) { return block.first == p; });
+    upstream_->deallocate(p, bytes, alignment);
+}
+
+bool Arena::Blocks::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace citymap
+{
+
+    /**
+     * Monotonic arena that several threads may allocate from at once.
+     *
+     * Memory is carved out of growing blocks and only given back by release() or the destructor,
+     * deallocating from a block is a no-op. A mutex is cheaper than it looks here: the parallel
+     * loaders mostly parse and rarely allocate, so it is nearly never contended.
+     *
+     * Once sealed the arena stops growing: new allocations come from the upstream resource and are
+     * freed there, memory in the blocks stays until release(). Seal it when the bulk build is done
+     * and the contents keep changing, e.g. a served map receiving updates.
+     */
+    class Arena final : public std::pmr::memory_resource {
+    public:
+        explicit Arena(std::size_t = 0,
+                       std::pmr::memory_resource* = std::pmr::new_delete_resource());
+        Arena(const Arena&) = delete;
+        ~Arena() override = default;
+
+        Arena& operator=(const Arena&) = delete;
+
+        void release();
+        void seal() noexcept;
+        bool sealed() const noexcept;
+
+    private:
+        // upstream of the monotonic buffer, remembers where its blocks are
+        class Blocks final : public std::pmr::memory_resource {
+        public:
+            explicit Blocks(std::pmr::memory_resource* upstream)
+                : upstream_(upstream) {}
+
+            bool owns(const void*) const noexcept;
+
+        private:
+            void* do_allocate(std::size_t, std::size_t) override;
+            void do_deallocate(void*, std::size_t, std::size_t) override;
+            bool do_is_equal(const std::pmr::memory_resource&) const noexcept override;
+
+            std::pmr::memory_resource* upstream_;
+            std::vector<std::pair<const std::byte*, std::size_t>> blocks_;
+        };
+
+        void* do_allocate(std::size_t, std::size_t) override;
+        void do_deallocate(void*, std::size_t, std::size_t) override;
+        bool do_is_equal(const std::pmr::memory_resource&) const noexcept override;
+
+        std::pmr::memory_resource* upstream_;
+        std::mutex mutex_;
+        std::atomic<bool> sealed_ {};
+        Blocks blocks_;
+        std::pmr::monotonic_buffer_resource buffer_;
+    };
+
+}  // namespace citymap
\ No newline at end of file
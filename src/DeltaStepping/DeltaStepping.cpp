@@ -0,0 +1,163 @@
+#include "DeltaStepping.h"
+
+#include <algorithm>
+#include <future>
+#include <limits>
+
+using namespace citymap;
+
+static constexpr double infinity = std::numeric_limits<double>::infinity();
+
+static constexpr std::size_t nbucket = static_cast<std::size_t>(-1);
+
+// mean edge length, default buckets are a few edges wide
+static double meanLength(const CompactGraph& graph, metrics::Metric metric) {
+    double sum {};
+    for (CompactGraph::Vertex u = 0; u < graph.size(); u++)
+        graph.forEachNeighbour(
+            u, [&](CompactGraph::Vertex v) { sum += metric(graph.point(u), graph.point(v)); });
+    return graph.edgeCount() ? sum / static_cast<double>(graph.edgeCount()) : 1.0;
+}
+
+// whether searches over the graph run faster spread over the pool than alone
+bool DeltaStepping::pays(const CompactGraph& graph, const ThreadPool* pool) noexcept {
+    return pool && pool->size() > 1 && graph.size() >= minVertices;
+}
+
+// delta <= 0 picks three mean edge lengths of the searched graph
+DeltaStepping::DeltaStepping(ThreadPool& pool, double delta)
+    : pool_(pool), requestedDelta_(delta) {}
+
+// shortest path tree of source, all of it or the vertices at most limit away
+void DeltaStepping::run(const CompactGraph& graph, Vertex source, metrics::Metric metric,
+                        double limit) {
+    parts_ = std::max<std::size_t>(1, pool_.size());
+    limit_ = limit;
+    delta_ = requestedDelta_ > 0 ? requestedDelta_ : 3.0 * meanLength(graph, metric);
+    if (delta_ <= 0) delta_ = 1.0;  // every edge has zero length
+
+    distance_.assign(graph.size(), infinity);
+    expanded_.assign(graph.size(), infinity);
+    parent_.assign(graph.size(), CompactGraph::nvtx);
+    buckets_.assign(parts_, {});
+    outbox_.assign(parts_, std::vector<std::vector<Request>>(parts_));
+    settled_.assign(parts_, {});
+    if (source >= graph.size()) return;
+
+    distance_[source] = 0.0;
+    parent_[source]   = source;
+    buckets_[ownerOf(source)].resize(1);
+    buckets_[ownerOf(source)][0].push_back(source);
+
+    for (auto b = nextBucket(0); b != nbucket; b = nextBucket(b + 1)) {
+        // light edges may refill the bucket, repeat until it stays empty
+        auto pending = [this, b] {
+            return std::ranges::any_of(buckets_, [b](auto& own) {
+                return b < own.size() && !own[b].empty();
+            });
+        };
+        while (pending()) {
+            parallel([&, b](std::size_t part) {
+                if (b >= buckets_[part].size()) return;
+                auto frontier = std::move(buckets_[part][b]);
+                buckets_[part][b].clear();
+                for (auto u : frontier) {
+                    // stale (moved to a lower bucket) or already expanded with this distance
+                    if (static_cast<std::size_t>(distance_[u] / delta_) != b
+                        || expanded_[u] == distance_[u])
+                        continue;
+                    if (expanded_[u] == infinity) settled_[part].push_back(u);
+                    expanded_[u] = distance_[u];
+                    relax(graph, metric, part, u, true);
+                }
+            });
+            parallel([this](std::size_t part) { apply(part); });
+        }
+
+        // heavy edges cannot land in the bucket itself, one round suffices
+        parallel([&](std::size_t part) {
+            for (auto u : settled_[part])
+                relax(graph, metric, part, u, false);
+            settled_[part].clear();
+        });
+        parallel([this](std::size_t part) { apply(part); });
+    }
+}
+
+double DeltaStepping::delta() const noexcept {
+    return delta_;
+}
+
+// infinity for vertices not reached by the last run
+double DeltaStepping::distance(Vertex v) const noexcept {
+    return distance_[v];
+}
+
+DeltaStepping::Vertex DeltaStepping::parent(Vertex v) const noexcept {
+    return parent_[v];
+}
+
+// vertices from the source to v, empty when v was not reached
+std::vector<DeltaStepping::Vertex> DeltaStepping::path(Vertex v) const {
+    std::vector<Vertex> path;
+    if (v >= parent_.size() || parent_[v] == CompactGraph::nvtx) return path;
+    for (; parent_[v] != v; v = parent_[v])
+        path.push_back(v);
+    path.push_back(v);
+    std::ranges::reverse(path);
+    return path;
+}
+
+// runs f(part) for every part, part 0 on the calling thread
+template<typename F>
+void DeltaStepping::parallel(F&& f) {
+    std::vector<std::future<void>> tasks;
+    tasks.reserve(parts_ - 1);
+    for (std::size_t part = 1; part < parts_; part++)
+        tasks.push_back(pool_.submit([&f, part] { f(part); }));
+    f(0);
+    for (auto& task : tasks)
+        task.get();
+}
+
+// sends the light or heavy edges of u (owned by part) to the owners of their targets
+void DeltaStepping::relax(const CompactGraph& graph, metrics::Metric metric, std::size_t part,
+                          Vertex u, bool light) {
+    graph.forEachNeighbour(u, [&](Vertex v) {
+        double length = metric(graph.point(u), graph.point(v));
+        if ((length <= delta_) == light && distance_[u] + length <= limit_)
+            outbox_[part][ownerOf(v)].push_back({v, u, distance_[u] + length});
+    });
+}
+
+// applies the requests for the vertices owned by part
+void DeltaStepping::apply(std::size_t part) {
+    auto& buckets = buckets_[part];
+    for (auto& outbox : outbox_) {
+        for (auto [v, parent, distance] : outbox[part]) {
+            if (distance >= distance_[v]) continue;
+            distance_[v] = distance;
+            parent_[v]   = parent;
+
+            auto b = static_cast<std::size_t>(distance / delta_);
+            if (b >= buckets.size()) buckets.resize(b + 1);
+            buckets[b].push_back(v);
+        }
+        outbox[part].clear();
+    }
+}
+
+std::size_t DeltaStepping::ownerOf(Vertex v) const noexcept {
+    return v % parts_;
+}
+
+// first non-empty bucket from b on, nbucket when all are empty
+std::size_t DeltaStepping::nextBucket(std::size_t b) const noexcept {
+    std::size_t last {};
+    for (auto& own : buckets_)
+        last = std::max(last, own.size());
+    for (; b < last; b++)
+        for (auto& own : buckets_)
+            if (b < own.size() && !own[b].empty()) return b;
+    return nbucket;
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "CompactGraph.h"
+#include "ThreadPool.h"
+#include "metrics.h"
+
+namespace citymap
+{
+
+    /**
+     * Parallel single source shortest paths (Meyer & Sanders delta-stepping).
+     *
+     * Tentative distances are kept in buckets of width delta. A bucket is emptied in phases
+     * relaxing light edges (<= delta) of its vertices in parallel, its heavy edges are relaxed
+     * once when it is settled. Vertices are partitioned among the workers, relaxations are
+     * sent to the owner of the target and applied by it, so no label is shared between threads.
+     * Distances equal those of Dijkstra exactly, parents may differ between equally short paths.
+     * Every bucket costs a few pool round trips, so it only beats Dijkstra on large graphs.
+     */
+    class DeltaStepping {
+    public:
+        using Vertex = CompactGraph::Vertex;
+
+        static constexpr std::size_t minVertices = std::size_t {1} << 16;
+
+        static bool pays(const CompactGraph&, const ThreadPool*) noexcept;
+
+        explicit DeltaStepping(ThreadPool&, double = 0.0);
+        ~DeltaStepping() = default;
+
+        void run(const CompactGraph&, Vertex, metrics::Metric,
+                 double = std::numeric_limits<double>::infinity());
+        double delta() const noexcept;
+        double distance(Vertex) const noexcept;
+        Vertex parent(Vertex) const noexcept;
+        std::vector<Vertex> path(Vertex) const;
+
+    private:
+        struct Request {
+            Vertex vertex;
+            Vertex parent;
+            double distance;
+        };
+
+        template<typename F>
+        void parallel(F&&);
+        void relax(const CompactGraph&, metrics::Metric, std::size_t, Vertex, bool);
+        void apply(std::size_t);
+        std::size_t ownerOf(Vertex) const noexcept;
+        std::size_t nextBucket(std::size_t) const noexcept;
+
+        ThreadPool& pool_;
+        double requestedDelta_;
+        double delta_ {};
+        double limit_ {};
+        std::size_t parts_ {};
+        std::vector<double> distance_;
+        std::vector<double> expanded_;  // distance a vertex was last expanded with
+        std::vector<Vertex> parent_;
+        std::vector<std::vector<std::vector<Vertex>>> buckets_;  // [owner][bucket]
+        std::vector<std::vector<std::vector<Request>>> outbox_;  // [sender][owner]
+        std::vector<std::vector<Vertex>> settled_;               // [owner], of the current bucket
+    };
+
+}  // namespace citymap
\ No newline at end of file
@@ -1,70 +1,215 @@
 #include "FileHandler.h"
 
 #include <algorithm>
+#include <array>
 #include <cctype>
 #include <charconv>
 #include <fstream>
+#include <future>
 #include <limits>
-#include <stdexcept>
+#include <optional>
+
+#include "RouteFile.h"
 
 using namespace citymap;
 
+namespace
+{
+
+    class Tokenizer {
+    public:
+        explicit Tokenizer(std::string_view text)
+            : rest_(text) {}
+
+        static constexpr bool isBlank(char c) noexcept {
+            return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+        }
+
+        // next whitespace separated token, empty at the end of input
+        std::string_view next() noexcept {
+            std::size_t begin = 0;
+            while (begin < rest_.size() && isBlank(rest_[begin]))
+                begin++;
+            std::size_t end = begin;
+            while (end < rest_.size() && !isBlank(rest_[end]))
+                end++;
+            auto token = rest_.substr(begin, end - begin);
+            rest_.remove_prefix(end);
+            return token;
+        }
+
+    private:
+        std::string_view rest_;
+    };
+
+    constexpr std::string_view nearestPrefix = "nearest:";
+
+    template<typename T>
+    bool parseNumber(std::string_view token, T& value) noexcept {
+        auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), value);
+        return !token.empty() && ec == std::errc {} && ptr == token.data() + token.size();
+    }
+
+}  // namespace
+
+// Loading runs as a small task graph on the pool: the matrix file is read and the
+// queries file tokenized while the coordinates are parsed on the calling thread.
+// Once the id sequence is known the matrix rows are parsed in parallel chunks,
+// overlapped with resolving the query points (which only need the name index).
+void FileHandler::loadInputs(const InputFiles& files, Map& map, std::vector<UnifiedQuery>& queries,
+                             PathType type, ThreadPool& pool, Tracer& tracer) {
+    if (fail()) return;
+
+    MappedFile matrix;
+    auto matrixRead = pool.submit([&] {
+        auto span = tracer.span("mapConnections", "load");
+        return openInputFile(files.connections, matrix);
+    });
+
+    MappedFile queriesFile;
+    std::vector<QueryLine> queryLines;
+    std::future<std::string> queriesRead;
+    if (!files.queries.empty()) {
+        queriesRead = pool.submit([&] {
+            auto span = tracer.span("tokenizeQueries", "load");
+            auto err  = openInputFile(files.queries, queriesFile);
+            return err.empty() ? tokenizeQueries(files.queries, queriesFile.view(), queryLines)
+                               : err;
+        });
+    }
+
+    {
+        auto span = tracer.span("loadCoordinates", "load");
+        loadCoordinates(files.coordinates, map);
+    }
+
+    // errors are reported in the same order as with sequential loading
+    std::string matrixErr  = matrixRead.get();
+    std::string queriesErr = queriesRead.valid() ? queriesRead.get() : std::string();
+    if (fail()) return;
+    if (!matrixErr.empty()) {
+        err_ = std::move(matrixErr);
+        return;
+    }
+
+    auto rows = splitLines(matrix.view());
+    checkConnectionRows(files.connections, rows);
+    if (fail()) return;
+
+    const std::size_t rowCount  = idSequence_.size();
+    const std::size_t chunkSize = std::max<std::size_t>(64, rowCount / (pool.size() * 4) + 1);
+    std::vector<std::future<std::size_t>> chunks;
+    for (std::size_t first = 0; first < rowCount; first += chunkSize) {
+        chunks.push_back(pool.submit([&, first] {
+            auto span = tracer.span("parseConnectionRows", "load");
+            return parseConnectionRows(rows, first, std::min(first + chunkSize, rowCount), map);
+        }));
+    }
+
+    if (!queriesErr.empty())
+        err_ = std::move(queriesErr);
+    else if (!files.queries.empty()) {
+        auto span = tracer.span("resolveQueryPoints", "load");
+        resolveQueries(queryLines, queries, type, map);
+    }
+
+    std::size_t badLine {};
+    for (auto& chunk : chunks)
+        if (auto line = chunk.get(); line && !badLine) badLine = line;
+    if (badLine)
+        err_ = "An error occured while reading file: " + files.connections.string()
+               + "\n Invalid or missing value(s) on line: " + std::to_string(badLine);
+}
+
 void FileHandler::loadCoordinates(FilePathRef path, Map& map) {
-    std::ifstream file(path);
-    if (fail() || !checkInputFile(path)) return;
+    if (fail()) return;
+    MappedFile file;
+    err_ = openInputFile(path, file);
+    if (fail()) return;
 
-    std::size_t lineCount {};
-    int id, x, y;
-    std::string name;
+    for (auto& line : splitLines(file.view())) {
+        Tokenizer tokens(line.text);
+        PointId id {};
+        std::string_view name, category;
+        int x, y;
 
-    while (file >> id >> name >> x >> y) {
-        lineCount++;
-        idSequence_.push_back(id);
-        if (Map::npnt == map.addPoint(id, name, {x, y})) {
+        // an optional fifth column overrides the category derived from the name
+        bool valid = parseNumber(tokens.next(), id) && !(name = tokens.next()).empty()
+                     && parseNumber(tokens.next(), x) && parseNumber(tokens.next(), y);
+        category   = tokens.next();
+        valid      = valid && tokens.next().empty();
+        if (valid) idSequence_.push_back(id);
+        if (!valid || Map::npnt == map.addPoint(id, name, {x, y})) {
             err_ = "An error occured while reading file: " + path.string()
-                   + "\n Invalid or missing parameter(s) on line: " + std::to_string(lineCount);
+                   + "\n Invalid or missing parameter(s) on line: " + std::to_string(line.number);
             break;
         }
+        if (!category.empty()) map.category(id, category);
     }
-    file.close();
 }
 
 void FileHandler::loadConnections(FilePathRef path, Map& map) {
-    if (fail() || !checkInputFile(path)) return;
-    std::ifstream file(path);
-    bool hasConnection;
+    if (fail()) return;
+    MappedFile matrix;
+    err_ = openInputFile(path, matrix);
+    if (fail()) return;
 
-    for (auto i : idSequence_) {
-        for (auto j : idSequence_) {
-            file >> hasConnection;
-            if (hasConnection) map.addConnection(i, j);
-        }
-        // skip whitespace, but don't exit on eof,
-        // because the loop will automatically end when the whole matrix is read,
-        // if any value is mising it will fail
-        if (!file.eof()) file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-    }
+    auto rows = splitLines(matrix.view());
+    checkConnectionRows(path, rows);
+    if (fail()) return;
 
-    if (!file) err_ = "An error occured while reading file: " + path.string();
-    file.close();
+    if (auto line = parseConnectionRows(rows, 0, idSequence_.size(), map))
+        err_ = "An error occured while reading file: " + path.string()
+               + "\n Invalid or missing value(s) on line: " + std::to_string(line);
+}
+
+// Only the row starts are indexed, searches parse the rows they reach (and report bad ones).
+void FileHandler::loadLazyConnections(FilePathRef path, std::unique_ptr<LazyGraph>& graph,
+                                      const Map& map) {
+    if (fail()) return;
+    MappedFile matrix;
+    err_ = openInputFile(path, matrix);
+    if (fail()) return;
+
+    graph = std::make_unique<LazyGraph>(std::move(matrix), path, idSequence_, map);
+    if (graph->rows() < idSequence_.size())
+        err_ = "An error occured while reading file: " + path.string()
+               + "\n Expected " + std::to_string(idSequence_.size()) + " rows, found "
+               + std::to_string(graph->rows());
 }
 
 void FileHandler::loadQueries(FilePathRef path, std::vector<UnifiedQuery>& queries, PathType type,
                               const Map& map) {
-    if (fail() || !checkInputFile(path)) return;
-    std::ifstream file(path);
-    std::string from, to;
-    while (file >> from >> to) {
-        if (!validateQueryPoints(from, to, map))
-            break;
-        else
-            queries.emplace_back(from, to, map, type);
+    if (fail()) return;
+    MappedFile file;
+    std::vector<QueryLine> lines;
+    err_ = openInputFile(path, file);
+    if (!fail()) err_ = tokenizeQueries(path, file.view(), lines);
+    if (!fail()) resolveQueries(lines, queries, type, map);
+}
 
-        if (file.eof()) break;
-    }
+// One '<centre> <budget>' per line, centres are resolved like query points.
+void FileHandler::loadIsochrones(FilePathRef path, std::vector<Isochrone>& isochrones,
+                                 PathType type, const Map& map) {
+    if (fail()) return;
+    MappedFile file;
+    err_ = openInputFile(path, file);
+    if (fail()) return;
 
-    if (!file) err_ = "An error occured while reading file: " + path.string();
-    file.close();
+    std::optional<SpatialIndex> index;
+    for (auto& line : splitLines(file.view())) {
+        Tokenizer tokens(line.text);
+        auto centre = tokens.next();
+        double budget;
+        if (!parseNumber(tokens.next(), budget) || !(budget >= 0.0) || !tokens.next().empty()) {
+            err_ = "An error occured while reading file: " + path.string()
+                   + "\n Expected <centre> <budget> on line: " + std::to_string(line.number);
+            return;
+        }
+        auto id = resolveQueryPoint(centre, line.number, map, index);
+        if (id == Map::npnt) return;
+        isochrones.emplace_back(id, budget, type);
+    }
 }
 
 void FileHandler::writeOutput(FilePathRef path, const PolymorphicPathList& paths, const Map& map) {
@@ -79,14 +224,122 @@ void FileHandler::writeOutput(FilePathRef path, const PolymorphicPathList& paths
         else
             file << "Car route: ";
 
-        file << map.describe({pptr->from(), pptr->to()}, " -> ");
+        file << map.describe(std::array {pptr->from(), pptr->to()}, " -> ");
         file << ' ' << pptr->distance() << '\n';
-        file << map.describe(*pptr, " -> ") << "\n\n";
+        file << map.describe(pptr->points(), " -> ") << "\n\n";
     });
     if (!file) err_ = "An error occured while writing to file: " + path.string();
     file.close();
 }
 
+// RouteFile layout. Unlike the text output unreachable routes are kept, one record per result.
+void FileHandler::writeBinaryOutput(FilePathRef path, const PolymorphicPathList& paths,
+                                    const Map& map) {
+    if (fail()) return;
+    std::ofstream file(path, std::ios::binary);
+    RouteFile::write(file, paths, map);
+    if (!file) err_ = "An error occured while writing to file: " + path.string();
+    file.close();
+}
+
+// One line per query like the route headers, unreachable ones are left out.
+void FileHandler::writeDistances(FilePathRef path,
+                                 const std::vector<std::pair<UnifiedQuery, double>>& distances,
+                                 const Map& map) {
+    if (fail()) return;
+    std::ofstream file(path);
+
+    for (auto& [query, distance] : distances) {
+        if (distance == std::numeric_limits<double>::infinity()) continue;
+        file << (query.type() == PathType::Pedestrian ? "Pedestrian distance: " : "Car distance: ")
+             << map.describe(query.get().stops(), " -> ") << ' ' << distance << '\n';
+    }
+    if (!file) err_ = "An error occured while writing to file: " + path.string();
+    file.close();
+}
+
+void FileHandler::writeIsochrones(FilePathRef path, const std::vector<Isochrone>& isochrones,
+                                  const Map& map, bool append) {
+    if (fail()) return;
+    std::ofstream file(path, append ? std::ios::app : std::ios::trunc);
+
+    for (auto& isochrone : isochrones) {
+        if (isochrone.type() == PathType::Pedestrian)
+            file << "Pedestrian isochrone: ";
+        else
+            file << "Car isochrone: ";
+
+        file << map.nameOf(isochrone.centre()) << ' ' << isochrone.budget() << " ("
+             << isochrone.points().size() << " points)\n";
+        for (auto [id, distance] : isochrone.points())
+            file << map.nameOf(id) << ' ' << distance << '\n';
+        file << '\n';
+    }
+    if (!file) err_ = "An error occured while writing to file: " + path.string();
+    file.close();
+}
+
+// Same layout as the routes, the hop count in place of the distance. Unreachable ones are left out.
+void FileHandler::writeHopRoutes(FilePathRef path, const std::vector<Path::PointList>& routes,
+                                 const Map& map, bool append) {
+    if (fail()) return;
+    std::ofstream file(path, append ? std::ios::app : std::ios::trunc);
+
+    for (auto& route : routes) {
+        if (route.empty()) continue;
+        file << "Fewest hops route: "
+             << map.describe(std::array {route.front(), route.back()}, " -> ") << ' '
+             << route.size() - 1 << '\n';
+        file << map.describe(route, " -> ") << "\n\n";
+    }
+    if (!file) err_ = "An error occured while writing to file: " + path.string();
+    file.close();
+}
+
+void FileHandler::writeTrace(FilePathRef path, const Tracer& tracer) {
+    if (fail()) return;
+    std::ofstream file(path);
+    tracer.writeChromeTrace(file);
+    if (!file) err_ = "An error occured while writing to file: " + path.string();
+    file.close();
+}
+
+void FileHandler::loadLandmarks(FilePathRef path, const CompactGraph& graph, Landmarks& landmarks) {
+    if (fail()) return;
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        err_ = "Could not open landmarks file: " + path.string();
+    else if (!landmarks.read(file, graph))
+        err_ = "File: " + path.string() + " does not hold landmarks of this map.";
+}
+
+void FileHandler::writeLandmarks(FilePathRef path, const CompactGraph& graph,
+                                 const Landmarks& landmarks) {
+    if (fail()) return;
+    std::ofstream file(path, std::ios::binary);
+    landmarks.write(file, graph);
+    if (!file) err_ = "An error occured while writing to file: " + path.string();
+    file.close();
+}
+
+void FileHandler::loadHubLabels(FilePathRef path, const CompactGraph& graph, HubLabels& labels) {
+    if (fail()) return;
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        err_ = "Could not open hub labels file: " + path.string();
+    else if (!labels.read(file, graph))
+        err_ = "File: " + path.string() + " does not hold hub labels of this map.";
+}
+
+void FileHandler::writeHubLabels(FilePathRef path, const CompactGraph& graph,
+                                 const HubLabels& labels) {
+    if (fail()) return;
+    std::ofstream file(path, std::ios::binary);
+    labels.write(file, graph);
+    if (!file) err_ = "An error occured while writing to file: " + path.string();
+    file.close();
+}
+
 bool FileHandler::fail() const noexcept {
     return !err_.empty();
 }
@@ -99,28 +352,134 @@ const std::string& FileHandler::error() const noexcept {
     return err_;
 }
 
-bool FileHandler::validateQueryPoints(const std::string& from, const std::string& to,
-                                      const Map& map) noexcept {
-    if (!map.contains(from)) {
-        err_ = "An error occured while reading connections file, key: " + from + " does not exist.";
-        return false;
+std::string FileHandler::openInputFile(FilePathRef path, MappedFile& file) {
+    if (!std::filesystem::exists(path) || !std::filesystem::is_regular_file(path)
+        || std::filesystem::is_empty(path))
+    {
+        return "File: " + path.string() + " does not exist, is empty or is not a regular file.";
     }
-    else if (!map.contains(to)) {
-        err_ = "An error occured while reading connections file, key: " + to + " does not exist.";
-        return false;
+    if (!file.open(path)) return "An error occured while reading file: " + path.string();
+    return {};
+}
+
+// Non-blank lines with their 1-based line numbers.
+std::vector<FileHandler::Line> FileHandler::splitLines(std::string_view text) {
+    std::vector<Line> lines;
+    std::size_t number {};
+    while (!text.empty()) {
+        auto nl   = text.find('\n');
+        auto line = text.substr(0, nl);
+        text      = nl == std::string_view::npos ? std::string_view() : text.substr(nl + 1);
+        number++;
+        if (line.find_first_not_of(" \t\r") != std::string_view::npos)
+            lines.emplace_back(line, number);
     }
-    else
-        return true;
+    return lines;
 }
 
-bool FileHandler::checkInputFile(FilePathRef path) {
-    if (std::filesystem::exists(path) && std::filesystem::is_regular_file(path)
-        && not std::filesystem::is_empty(path))
-    {
-        return true;
+// The views point into the mapped file, which has to outlive them.
+std::string FileHandler::tokenizeQueries(FilePathRef path, std::string_view text,
+                                         std::vector<QueryLine>& queries) {
+    for (auto& line : splitLines(text)) {
+        Tokenizer tokens(line.text);
+        auto from = tokens.next();
+        auto to   = tokens.next();
+        if (to.empty())
+            return "An error occured while reading file: " + path.string()
+                   + "\n Expected <from> [<via>...] <to> on line: " + std::to_string(line.number);
+
+        auto& query = queries.emplace_back(from, to, line.number);
+        for (auto next = tokens.next(); !next.empty(); next = tokens.next()) {
+            query.via.push_back(query.to);
+            query.to = next;
+        }
     }
-    else {
-        err_ = "File: " + path.string() + " does not exist, is empty or is not a regular file.";
-        return false;
+    return {};
+}
+
+// Parses matrix rows [first, last), rows of distinct points can be parsed concurrently.
+// Each row is added as one batch. Returns the line number of the first malformed row or 0.
+std::size_t FileHandler::parseConnectionRows(const std::vector<Line>& rows, std::size_t first,
+                                             std::size_t last, Map& map) const {
+    std::vector<PointId> targets;
+    for (std::size_t r = first; r < last; r++) {
+        const char* it  = rows[r].text.data();
+        const char* end = it + rows[r].text.size();
+        targets.clear();
+        for (auto j : idSequence_) {
+            while (it < end && Tokenizer::isBlank(*it))
+                it++;
+            unsigned value;
+            auto [next, ec] = std::from_chars(it, end, value);
+            if (ec != std::errc {} || value > 1) return rows[r].number;
+            if (value) targets.push_back(j);
+            it = next;
+        }
+        map.addConnections(idSequence_[r], targets);
+    }
+    return 0;
+}
+
+void FileHandler::checkConnectionRows(FilePathRef path, const std::vector<Line>& rows) {
+    if (rows.size() < idSequence_.size())
+        err_ = "An error occured while reading file: " + path.string()
+               + "\n Expected " + std::to_string(idSequence_.size()) + " rows, found "
+               + std::to_string(rows.size());
+}
+
+// Each endpoint is resolved with a single name index lookup, "@x,y" endpoints are
+// snapped to the nearest point (the spatial index is only built when needed).
+void FileHandler::resolveQueries(const std::vector<QueryLine>& lines,
+                                 std::vector<UnifiedQuery>& queries, PathType type,
+                                 const Map& map) {
+    std::optional<SpatialIndex> index;
+    queries.reserve(queries.size() + lines.size());
+    for (auto& line : lines) {
+        // '<from> nearest:<category>', a '*' origin asks for every point
+        if (line.to.starts_with(nearestPrefix)) {
+            if (!line.via.empty()) {
+                err_ = "An error occured while reading queries file, nearest: routes take no"
+                       " waypoints (line: " + std::to_string(line.number) + ").";
+                return;
+            }
+            auto category = map.findCategory(line.to.substr(nearestPrefix.size()));
+            if (category == Map::ncat) {
+                err_ = "An error occured while reading queries file, category: "
+                       + std::string(line.to.substr(nearestPrefix.size()))
+                       + " does not exist (line: " + std::to_string(line.number) + ").";
+                return;
+            }
+            auto from = line.from == "*" ? Map::npnt
+                                         : resolveQueryPoint(line.from, line.number, map, index);
+            if (fail()) return;
+            queries.emplace_back(from, Map::npnt, type).nearest(category);
+            continue;
+        }
+
+        auto from = resolveQueryPoint(line.from, line.number, map, index);
+        std::vector<PointId> via;
+        for (auto stop : line.via)
+            if (!fail()) via.push_back(resolveQueryPoint(stop, line.number, map, index));
+        auto to = fail() ? Map::npnt : resolveQueryPoint(line.to, line.number, map, index);
+        if (to == Map::npnt) return;
+        queries.emplace_back(from, to, type).via(std::move(via));
+    }
+}
+
+PointId FileHandler::resolveQueryPoint(std::string_view token, std::size_t line, const Map& map,
+                                       std::optional<SpatialIndex>& index) {
+    PointId id = Map::npnt;
+    if (Point location; token.starts_with('@')) {
+        if (parseCoordinates(token, location)) {
+            if (!index) index.emplace(map);
+            id = index->nearest(location);
+        }
     }
+    else
+        id = map.find(token);
+
+    if (id == Map::npnt)
+        err_ = "An error occured while reading queries file, key: " + std::string(token)
+               + " does not exist or is not valid (line: " + std::to_string(line) + ").";
+    return id;
 }
\ No newline at end of file
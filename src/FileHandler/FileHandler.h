@@ -1,12 +1,25 @@
 #pragma once
 
+#include <cstddef>
 #include <filesystem>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
+#include "HubLabels.h"
+#include "Isochrone.h"
+#include "Landmarks.h"
+#include "LazyGraph.h"
 #include "Map.h"
+#include "MappedFile.h"
 #include "Path.h"
 #include "Query.h"
+#include "SpatialIndex.h"
+#include "ThreadPool.h"
+#include "Tracer.h"
 
 namespace citymap
 {
@@ -16,20 +29,60 @@ namespace citymap
         using FilePathRef = const std::filesystem::path&;
 
     public:
+        struct InputFiles {
+            FilePath coordinates;
+            FilePath connections;
+            FilePath queries;  // optional
+        };
+
         FileHandler()  = default;
         ~FileHandler() = default;
 
+        void loadInputs(const InputFiles&, Map&, std::vector<UnifiedQuery>&, PathType, ThreadPool&,
+                        Tracer&);
         void loadCoordinates(FilePathRef, Map&);
         void loadConnections(FilePathRef, Map&);
+        void loadLazyConnections(FilePathRef, std::unique_ptr<LazyGraph>&, const Map&);
         void loadQueries(FilePathRef, std::vector<UnifiedQuery>&, PathType, const Map&);
+        void loadIsochrones(FilePathRef, std::vector<Isochrone>&, PathType, const Map&);
         void writeOutput(FilePathRef, const PolymorphicPathList&, const Map&);
+        void writeBinaryOutput(FilePathRef, const PolymorphicPathList&, const Map&);
+        void writeDistances(FilePathRef, const std::vector<std::pair<UnifiedQuery, double>>&,
+                            const Map&);
+        void writeIsochrones(FilePathRef, const std::vector<Isochrone>&, const Map&, bool = false);
+        void writeHopRoutes(FilePathRef, const std::vector<Path::PointList>&, const Map&,
+                            bool = false);
+        void writeTrace(FilePathRef, const Tracer&);
+        void loadLandmarks(FilePathRef, const CompactGraph&, Landmarks&);
+        void writeLandmarks(FilePathRef, const CompactGraph&, const Landmarks&);
+        void loadHubLabels(FilePathRef, const CompactGraph&, HubLabels&);
+        void writeHubLabels(FilePathRef, const CompactGraph&, const HubLabels&);
         bool fail() const noexcept;
         void clear() noexcept;
         const std::string& error() const noexcept;
 
     private:
-        bool validateQueryPoints(const std::string&, const std::string&, const Map&) noexcept;
-        bool checkInputFile(FilePathRef);
+        struct Line {
+            std::string_view text;
+            std::size_t number;
+        };
+
+        struct QueryLine {
+            std::string_view from, to;
+            std::size_t number;
+            std::vector<std::string_view> via {};  // waypoints of a multi-stop route
+        };
+
+        static std::string openInputFile(FilePathRef, MappedFile&);
+        static std::vector<Line> splitLines(std::string_view);
+        static std::string tokenizeQueries(FilePathRef, std::string_view, std::vector<QueryLine>&);
+        std::size_t parseConnectionRows(const std::vector<Line>&, std::size_t, std::size_t,
+                                        Map&) const;
+        void checkConnectionRows(FilePathRef, const std::vector<Line>&);
+        void resolveQueries(const std::vector<QueryLine>&, std::vector<UnifiedQuery>&, PathType,
+                            const Map&);
+        PointId resolveQueryPoint(std::string_view, std::size_t, const Map&,
+                                  std::optional<SpatialIndex>&);
 
         std::string err_;
         std::vector<PointId> idSequence_;
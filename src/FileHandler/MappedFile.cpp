@@ -0,0 +1,62 @@
+#include "MappedFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <utility>
+
+using namespace citymap;
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)) {}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+bool MappedFile::open(const std::filesystem::path& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat info {};
+    if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+        void* addr = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            ::madvise(addr, info.st_size, MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(addr);
+            size_ = static_cast<std::size_t>(info.st_size);
+        }
+    }
+    ::close(fd);  // the mapping stays valid
+    return isOpen();
+}
+
+void MappedFile::close() noexcept {
+    if (data_) ::munmap(const_cast<char*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+}
+
+bool MappedFile::isOpen() const noexcept {
+    return data_ != nullptr;
+}
+
+std::string_view MappedFile::view() const noexcept {
+    return {data_, size_};
+}
+
+std::size_t MappedFile::size() const noexcept {
+    return size_;
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+
+namespace citymap
+{
+
+    /// Read-only memory mapping of a whole file.
+    class MappedFile {
+    public:
+        MappedFile()                  = default;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile(MappedFile&&) noexcept;
+        ~MappedFile();
+
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile& operator=(MappedFile&&) noexcept;
+
+        bool open(const std::filesystem::path&);
+        void close() noexcept;
+        bool isOpen() const noexcept;
+        std::string_view view() const noexcept;
+        std::size_t size() const noexcept;
+
+    private:
+        const char* data_ {};
+        std::size_t size_ {};
+    };
+
+}  // namespace citymap
\ No newline at end of file
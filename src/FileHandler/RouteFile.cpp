@@ -0,0 +1,126 @@
+#include "RouteFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace citymap;
+
+static_assert(sizeof(RouteFile::Header) == 64 && sizeof(RouteFile::NameEntry) == 24
+              && sizeof(RouteFile::Record) == 40 && sizeof(PointId) == sizeof(std::uint64_t));
+
+static std::uint64_t aligned(std::uint64_t offset) noexcept {
+    return (offset + 7) & ~std::uint64_t {7};
+}
+
+template<typename T>
+static void writeArray(std::ostream& out, const std::vector<T>& values) {
+    out.write(reinterpret_cast<const char*>(values.data()),
+              static_cast<std::streamsize>(values.size() * sizeof(T)));
+}
+
+// count Ts at offset, empty when they do not fit in the file
+template<typename T>
+static std::span<const T> section(std::string_view file, std::uint64_t offset,
+                                  std::uint64_t count) noexcept {
+    if (offset % alignof(T) || offset > file.size()
+        || count > (file.size() - offset) / sizeof(T))
+        return {};
+    return {reinterpret_cast<const T*>(file.data() + offset), count};
+}
+
+void RouteFile::write(std::ostream& out, const PolymorphicPathList& paths, const Map& map) {
+    auto ids = map.ids();
+    std::ranges::sort(ids);
+    std::vector<NameEntry> names;
+    names.reserve(ids.size());
+    std::string text;
+    for (auto id : ids) {
+        auto name = map.nameOf(id);
+        names.push_back({id, text.size(), name.size()});
+        text += name;
+    }
+
+    std::vector<Record> records;
+    records.reserve(paths.size());
+    std::uint64_t points {};
+    for (auto& path : paths) {
+        auto length   = static_cast<std::uint32_t>(path->points().size());
+        auto distance = length ? path->distance() : std::numeric_limits<double>::infinity();
+        records.push_back({static_cast<std::uint32_t>(path->type()), length, path->from(),
+                           path->to(), distance, points});
+        points += length;
+    }
+
+    Header header {};
+    std::memcpy(header.magic, fileMagic, sizeof(fileMagic));
+    header.names         = names.size();
+    header.routes        = records.size();
+    header.points        = points;
+    header.namesOffset   = sizeof(Header);
+    header.textOffset    = header.namesOffset + names.size() * sizeof(NameEntry);
+    header.recordsOffset = aligned(header.textOffset + text.size());
+    header.pointsOffset  = header.recordsOffset + records.size() * sizeof(Record);
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writeArray(out, names);
+    out.write(text.data(), static_cast<std::streamsize>(text.size()));
+    auto padding = header.recordsOffset - header.textOffset - text.size();
+    out.write("\0\0\0\0\0\0\0", static_cast<std::streamsize>(padding));
+    writeArray(out, records);
+    for (auto& path : paths)
+        out.write(reinterpret_cast<const char*>(path->points().data()),
+                  static_cast<std::streamsize>(path->points().size() * sizeof(std::uint64_t)));
+}
+
+bool RouteFile::open(const std::filesystem::path& path) {
+    names_   = {};
+    text_    = {};
+    records_ = {};
+    points_  = {};
+    if (!file_.open(path) || file_.size() < sizeof(Header)) return false;
+
+    auto view   = file_.view();
+    auto header = reinterpret_cast<const Header*>(view.data());
+    if (std::memcmp(header->magic, fileMagic, sizeof(fileMagic)) != 0) return false;
+    if (header->recordsOffset < header->textOffset) return false;
+    auto textSize = header->recordsOffset - header->textOffset;
+    auto names    = section<NameEntry>(view, header->namesOffset, header->names);
+    auto text     = section<char>(view, header->textOffset, textSize);
+    auto records  = section<Record>(view, header->recordsOffset, header->routes);
+    auto points   = section<std::uint64_t>(view, header->pointsOffset, header->points);
+    if (names.size() != header->names || text.size() != textSize
+        || records.size() != header->routes || points.size() != header->points)
+        return false;
+
+    names_   = names;
+    text_    = {text.data(), text.size()};
+    records_ = records;
+    points_  = points;
+    return true;
+}
+
+std::size_t RouteFile::size() const noexcept {
+    return records_.size();
+}
+
+const RouteFile::Record& RouteFile::record(std::size_t i) const noexcept {
+    return records_[i];
+}
+
+// empty as well when the record points outside of the file
+std::span<const std::uint64_t> RouteFile::points(std::size_t i) const noexcept {
+    auto [offset, length] = std::pair(records_[i].offset, records_[i].length);
+    if (offset > points_.size() || length > points_.size() - offset) return {};
+    return points_.subspan(offset, length);
+}
+
+// empty when the id has no entry
+std::string_view RouteFile::name(PointId id) const noexcept {
+    auto it = std::ranges::lower_bound(names_, id, {}, &NameEntry::id);
+    if (it == names_.end() || it->id != id || it->offset > text_.size()) return {};
+    return text_.substr(it->offset, it->length);
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+#include <span>
+#include <string_view>
+
+#include "Map.h"
+#include "MappedFile.h"
+#include "Path.h"
+
+namespace citymap
+{
+
+    /**
+     * Binary route output (--out-format bin), meant to be memory-mapped and read in place.
+     *
+     * Native byte order, every section starts 8-byte aligned at the offset the header gives:
+     *   Header
+     *   NameEntry[names]   every point of the map by ascending id, its name in the text section
+     *   char text[]        the names back to back, not terminated
+     *   Record[routes]     one per route in output order, unreachable ones have no points but
+     *                      keep the endpoints of their query
+     *   uint64 points[]    the PointIds of the routes back to back
+     */
+    class RouteFile {
+    public:
+        static constexpr char fileMagic[8] = {'C', 'I', 'T', 'Y', 'R', 'T', 'E', '1'};
+
+        struct Header {
+            char magic[8];
+            std::uint64_t names, routes, points;  // entry counts
+            std::uint64_t namesOffset, textOffset, recordsOffset, pointsOffset;
+        };
+
+        struct NameEntry {
+            std::uint64_t id;
+            std::uint64_t offset;  // into the text section
+            std::uint64_t length;
+        };
+
+        struct Record {
+            std::uint32_t type;    // PathType
+            std::uint32_t length;  // points, 0 when unreachable
+            std::uint64_t from, to;  // to is npnt for a nearest: query that reached no facility
+            double distance;       // infinity when unreachable
+            std::uint64_t offset;  // first point, in points
+        };
+
+        static void write(std::ostream&, const PolymorphicPathList&, const Map&);
+
+        RouteFile() = default;
+
+        bool open(const std::filesystem::path&);  // false unless it is a complete route file
+        std::size_t size() const noexcept;
+        const Record& record(std::size_t) const noexcept;
+        std::span<const std::uint64_t> points(std::size_t) const noexcept;
+        std::string_view name(PointId) const noexcept;
+
+    private:
+        MappedFile file_;
+        std::span<const NameEntry> names_;
+        std::string_view text_;
+        std::span<const Record> records_;
+        std::span<const std::uint64_t> points_;
+    };
+
+}  // namespace citymap
\ No newline at end of file
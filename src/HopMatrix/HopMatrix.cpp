@@ -0,0 +1,196 @@
+#include "HopMatrix.h"
+
+#include <algorithm>
+#include <bit>
+#include <numeric>
+
+using namespace citymap;
+
+static constexpr std::size_t wordBits = 64;
+
+static bool testBit(std::span<const HopMatrix::Word> bits, std::size_t i) noexcept {
+    return bits[i / wordBits] >> (i % wordBits) & 1;
+}
+
+static void setBit(std::span<HopMatrix::Word> bits, std::size_t i) noexcept {
+    bits[i / wordBits] |= HopMatrix::Word {1} << (i % wordBits);
+}
+
+// f(i) for every set bit i of the words [first, last), ascending
+template<typename F>
+static void forEachBit(std::span<const HopMatrix::Word> bits, std::size_t first, std::size_t last,
+                       F f) {
+    for (std::size_t w = first; w < last; w++)
+        for (auto word = bits[w]; word; word &= word - 1)
+            f(w * wordBits + std::countr_zero(word));
+}
+
+// lowest set bit i of the words for which pred(i) holds, npos when there is none
+template<typename Pred>
+static std::size_t findBit(std::span<const HopMatrix::Word> bits, Pred pred) {
+    for (std::size_t w = 0; w < bits.size(); w++)
+        for (auto word = bits[w]; word; word &= word - 1)
+            if (auto i = w * wordBits + std::countr_zero(word); pred(i)) return i;
+    return static_cast<std::size_t>(-1);
+}
+
+HopMatrix::HopMatrix(const CompactGraph& graph)
+    : size_(graph.size()), words_((graph.size() + wordBits - 1) / wordBits),
+      out_(size_ * words_), in_(size_ * words_), extents_(size_) {
+    for (Vertex u = 0; u < size_; u++) {
+        std::size_t first = words_, last = 0;
+        graph.forEachNeighbour(u, [&](Vertex v) {
+            setBit(std::span(out_).subspan(u * words_, words_), v);
+            setBit(std::span(in_).subspan(v * words_, words_), u);
+            first = std::min<std::size_t>(first, v / wordBits);
+            last  = std::max<std::size_t>(last, v / wordBits + 1);
+        });
+        extents_[u] = {static_cast<std::uint32_t>(std::min(first, last)),
+                       static_cast<std::uint32_t>(last)};
+    }
+}
+
+std::size_t HopMatrix::size() const noexcept {
+    return size_;
+}
+
+bool HopMatrix::connected(Vertex source, Vertex target) const {
+    return !route(source, target).empty();
+}
+
+// Fewest hops from source to target, empty when it is unreachable. The frontier is a bit set:
+// the next level is the OR of the rows of its vertices AND-NOT everything seen so far. Levels
+// are kept to walk back from the target over the incoming connections.
+std::vector<HopMatrix::Vertex> HopMatrix::route(Vertex source, Vertex target) const {
+    std::vector<Vertex> route;
+    std::vector<Word> seen(words_), levels(words_);  // level major frontiers
+    setBit(seen, source);
+    setBit(levels, source);
+
+    std::size_t depth = 0;
+    while (!testBit(seen, target)) {
+        levels.resize(levels.size() + words_);
+        auto frontier = std::span(levels).subspan(depth * words_, words_);
+        auto next     = std::span(levels).subspan((depth + 1) * words_, words_);
+        forEachBit(frontier, 0, words_, [&](std::size_t u) {
+            auto connections   = row(static_cast<Vertex>(u));
+            auto [first, last] = extents_[u];
+            for (auto w = first; w < last; w++)
+                next[w] |= connections[w];
+        });
+
+        Word any {};
+        for (std::size_t w = 0; w < words_; w++) {
+            next[w] &= ~seen[w];
+            seen[w] |= next[w];
+            any |= next[w];
+        }
+        if (!any) return route;
+        depth++;
+    }
+
+    route.resize(depth + 1);
+    route[depth] = target;
+    for (auto d = depth; d > 0; d--) {
+        auto previous = std::span(levels).subspan((d - 1) * words_, words_);
+        route[d - 1]  = static_cast<Vertex>(
+            findBit(column(route[d]), [&](std::size_t u) { return testBit(previous, u); }));
+    }
+    return route;
+}
+
+// Queries in sweeps of up to 64 sources, lane i of a sweep searching from one source for all the
+// targets queried from it. Sources are taken in ascending order, near each other in a Hilbert
+// ordered snapshot, so lanes tend to reach a vertex on the same level. A lone query runs route().
+std::vector<std::vector<HopMatrix::Vertex>>
+HopMatrix::routes(std::span<const std::pair<Vertex, Vertex>> queries) const {
+    std::vector<std::size_t> order(queries.size());
+    std::iota(order.begin(), order.end(), std::size_t {0});
+    std::ranges::stable_sort(order, {}, [queries](std::size_t q) { return queries[q].first; });
+
+    std::vector<std::vector<Vertex>> routes(queries.size());
+    std::vector<Vertex> sources;
+    std::vector<Leg> legs;
+    for (std::size_t first = 0, last = 0; first < order.size(); first = last) {
+        sources.clear();
+        legs.clear();
+        for (; last < order.size(); last++) {
+            auto [source, target] = queries[order[last]];
+            if (sources.empty() || sources.back() != source) {
+                if (sources.size() == lanes) break;
+                sources.push_back(source);
+            }
+            legs.push_back({sources.size() - 1, target, order[last]});
+        }
+        if (legs.size() == 1)
+            routes[order[first]] = route(sources.front(), legs.front().target);
+        else
+            sweep(sources, legs, routes);
+    }
+    return routes;
+}
+
+std::span<const HopMatrix::Word> HopMatrix::row(Vertex v) const noexcept {
+    return std::span(out_).subspan(v * words_, words_);
+}
+
+std::span<const HopMatrix::Word> HopMatrix::column(Vertex v) const noexcept {
+    return std::span(in_).subspan(v * words_, words_);
+}
+
+// Multi-source BFS, lane i searching from sources[i]. visit[v] holds the lanes that reached v on
+// the current level, so one pass over the row of v advances all of them at once. Lanes stop once
+// the targets of all their legs are seen, hops are kept per lane to walk the routes back.
+void HopMatrix::sweep(std::span<const Vertex> sources, std::span<const Leg> legs,
+                      std::span<std::vector<Vertex>> routes) const {
+    std::vector<Word> seen(size_), visit(size_), next(size_);
+    std::vector<Vertex> frontier, upcoming;          // vertices with a visit / next word set
+    std::vector<std::uint32_t> hops(size_ * lanes);  // valid where the seen bit is set
+    for (std::size_t i = 0; i < sources.size(); i++) {
+        Word lane = Word {1} << i;
+        if (!visit[sources[i]]) frontier.push_back(sources[i]);
+        seen[sources[i]] |= lane;
+        visit[sources[i]] |= lane;
+        hops[sources[i] * lanes + i] = 0;
+    }
+
+    std::vector<Leg> open(legs.begin(), legs.end());  // legs whose target is not seen yet
+    for (std::uint32_t level = 0; !frontier.empty(); level++) {
+        Word pending {};
+        std::erase_if(open, [&](const Leg& leg) { return seen[leg.target] >> leg.lane & 1; });
+        for (auto& leg : open)
+            pending |= Word {1} << leg.lane;
+        if (!pending) break;
+
+        for (auto u : frontier) {
+            Word active = visit[u] & pending;
+            visit[u]    = 0;
+            if (!active) continue;
+            auto [first, last] = extents_[u];
+            forEachBit(row(u), first, last, [&](std::size_t v) {
+                Word fresh = active & ~seen[v];
+                if (!fresh) return;
+                if (!next[v]) upcoming.push_back(static_cast<Vertex>(v));
+                seen[v] |= fresh;
+                next[v] |= fresh;
+                for (; fresh; fresh &= fresh - 1)
+                    hops[v * lanes + std::countr_zero(fresh)] = level + 1;
+            });
+        }
+        visit.swap(next);
+        frontier.swap(upcoming);
+        upcoming.clear();
+    }
+
+    for (auto [i, target, query] : legs) {
+        if (!(seen[target] >> i & 1)) continue;
+        auto& route = routes[query];
+        route.resize(hops[target * lanes + i] + 1);
+        route.back() = target;
+        for (auto d = route.size() - 1; d > 0; d--) {
+            route[d - 1] = static_cast<Vertex>(findBit(column(route[d]), [&](std::size_t u) {
+                return (seen[u] >> i & 1) && hops[u * lanes + i] == d - 1;
+            }));
+        }
+    }
+}
\ No newline at end of file
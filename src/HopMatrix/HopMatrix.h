@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "CompactGraph.h"
+
+namespace citymap
+{
+
+    /**
+     * Road network as a packed bit matrix, for routes with the fewest hops (intersections).
+     *
+     * Row v has a bit for every vertex v connects to, a transposed copy holds the incoming
+     * connections. A BFS level is then a few word-wide OR / AND-NOT passes over the rows of its
+     * frontier, and the multi-source BFS carries up to 64 searches in the bits of one word per
+     * vertex. Takes n^2 / 4 bytes, it pays off on small dense districts rather than whole cities.
+     */
+    class HopMatrix {
+    public:
+        using Vertex = CompactGraph::Vertex;
+        using Word   = std::uint64_t;
+
+        static constexpr std::size_t lanes = 64;  // searches per multi-source sweep
+
+        HopMatrix() = default;
+        explicit HopMatrix(const CompactGraph&);
+        ~HopMatrix() = default;
+
+        std::size_t size() const noexcept;
+        bool connected(Vertex, Vertex) const;
+        std::vector<Vertex> route(Vertex, Vertex) const;
+        std::vector<std::vector<Vertex>> routes(std::span<const std::pair<Vertex, Vertex>>) const;
+
+    private:
+        struct Leg {
+            std::size_t lane;
+            Vertex target;
+            std::size_t query;  // index of the route
+        };
+
+        std::span<const Word> row(Vertex) const noexcept;
+        std::span<const Word> column(Vertex) const noexcept;
+        void sweep(std::span<const Vertex>, std::span<const Leg>,
+                   std::span<std::vector<Vertex>>) const;
+
+        std::size_t size_ {};
+        std::size_t words_ {};   // per row
+        std::vector<Word> out_;  // row major, u -> v
+        std::vector<Word> in_;   // transposed, v <- u
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> extents_;  // non-zero words of a row
+    };
+
+}  // namespace citymap
\ No newline at end of file
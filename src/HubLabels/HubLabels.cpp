@@ -0,0 +1,372 @@
+#include "HubLabels.h"
+
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+#include "Map.h"
+
+using namespace citymap;
+
+using Vertex = HubLabels::Vertex;
+using Entry  = HubLabels::Entry;
+
+static constexpr char fileMagic[8] = {'C', 'I', 'T', 'Y', 'H', 'U', 'B', '1'};
+
+static constexpr double infinity = std::numeric_limits<double>::infinity();
+
+// label length in entries is a multiple of this, 64 bytes of hubs
+static constexpr std::size_t lineEntries = 64 / sizeof(Vertex);
+
+// witness searches give up after settling this many vertices and keep the shortcut
+static constexpr std::size_t witnessLimit = 64;
+
+template<typename T>
+static void writeValue(std::ostream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template<typename T>
+static bool readValue(std::istream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+namespace
+{
+
+    struct Arc {
+        Vertex to;
+        double length;
+    };
+
+    /**
+     * Contraction of one metric, only to rank the vertices: the shortcuts are thrown away.
+     * Vertices go in the order of their priority, the edge difference plus the number of
+     * contracted neighbours, updated lazily when they come up.
+     */
+    class Contraction {
+    public:
+        Contraction(const CompactGraph& graph, metrics::Metric metric)
+            : graph_(graph), out_(graph.size()), in_(graph.size()), deleted_(graph.size()) {
+            for (Vertex u = 0; u < graph.size(); u++)
+                graph.forEachNeighbour(u, [&](Vertex v) {
+                    if (u != v) connect(u, v, metric(graph.point(u), graph.point(v)));
+                });
+        }
+
+        // vertices by rank, the most important (contracted last) first
+        std::vector<Vertex> order() {
+            using Key = std::pair<long, Vertex>;
+            std::vector<Key> heap;
+            for (Vertex v = 0; v < out_.size(); v++)
+                heap.emplace_back(priority(v), v);
+            std::ranges::make_heap(heap, std::greater {});
+
+            std::vector<Vertex> byRank;
+            byRank.reserve(out_.size());
+            while (!heap.empty()) {
+                std::ranges::pop_heap(heap, std::greater {});
+                auto v = heap.back().second;
+                heap.pop_back();
+                if (long current = priority(v); !heap.empty() && current > heap.front().first) {
+                    heap.emplace_back(current, v);
+                    std::ranges::push_heap(heap, std::greater {});
+                    continue;
+                }
+                contract(v);
+                byRank.push_back(v);
+            }
+            std::ranges::reverse(byRank);
+            return byRank;
+        }
+
+    private:
+        // adds u -> v or shortens it
+        void connect(Vertex u, Vertex v, double length) {
+            auto update = [length](std::vector<Arc>& arcs, Vertex to) {
+                auto it = std::ranges::find(arcs, to, &Arc::to);
+                if (it == arcs.end())
+                    arcs.push_back({to, length});
+                else
+                    it->length = std::min(it->length, length);
+            };
+            update(out_[u], v);
+            update(in_[v], u);
+        }
+
+        // shortcuts u -> w needed to keep distances when v is taken out, added when apply
+        std::size_t shortcuts(Vertex v, bool apply) {
+            std::size_t count {};
+            for (auto [u, toV] : in_[v]) {
+                double longest = 0.0;
+                for (auto [w, fromV] : out_[v])
+                    if (w != u) longest = std::max(longest, fromV);
+                witness(u, v, toV + longest);
+                for (auto [w, fromV] : out_[v]) {
+                    if (w == u || tree_.distance(w) <= toV + fromV) continue;
+                    count++;
+                    if (apply) connect(u, w, toV + fromV);
+                }
+            }
+            return count;
+        }
+
+        // distances from u avoiding v, within limit or the first witnessLimit vertices
+        void witness(Vertex u, Vertex v, double limit) {
+            std::size_t settled {};
+            auto done = [this, &settled, limit](Vertex x) {
+                return ++settled > witnessLimit || tree_.distance(x) > limit;
+            };
+            auto arcs = [this, v](Vertex x, auto&& relax) {
+                for (auto [to, length] : out_[x])
+                    if (to != v) relax(to, length);
+            };
+            graphs::search(graph_, std::views::single(u), arcs, graphs::noPotential, done, tree_);
+        }
+
+        long priority(Vertex v) {
+            auto added = static_cast<long>(shortcuts(v, false));
+            return added - static_cast<long>(in_[v].size() + out_[v].size()) + deleted_[v];
+        }
+
+        void contract(Vertex v) {
+            shortcuts(v, true);
+            for (auto [u, length] : in_[v]) {
+                std::erase_if(out_[u], [v](const Arc& arc) { return arc.to == v; });
+                deleted_[u]++;
+            }
+            for (auto [w, length] : out_[v]) {
+                std::erase_if(in_[w], [v](const Arc& arc) { return arc.to == v; });
+                deleted_[w]++;
+            }
+            out_[v].clear();
+            in_[v].clear();
+        }
+
+        const CompactGraph& graph_;  // sizes the labels, arcs come from out_
+        std::vector<std::vector<Arc>> out_, in_;  // between vertices not contracted yet
+        std::vector<long> deleted_;  // contracted neighbours
+        SearchTree tree_;
+    };
+
+    // Pruned labeling: a search from each vertex by rank adds it as a hub to the labels of the
+    // vertices it reaches, unless the labels so far already give a distance as short.
+    class Labeling {
+    public:
+        Labeling(const CompactGraph& graph, metrics::Metric metric)
+            : graph_(graph), metric_(metric), forward_(graph.size()), backward_(graph.size()),
+              root_(graph.size(), infinity) {}
+
+        // forward and backward labels of every vertex, hubs ascending
+        std::pair<std::vector<std::vector<Entry>>, std::vector<std::vector<Entry>>> run(
+            const std::vector<Vertex>& byRank) {
+            for (Vertex rank = 0; rank < byRank.size(); rank++) {
+                search<false>(byRank[rank], rank);
+                search<true>(byRank[rank], rank);
+            }
+            return {std::move(forward_), std::move(backward_)};
+        }
+
+    private:
+        // From the root: d(root, v) into backward labels, or d(v, root) into forward labels over
+        // incoming arcs when reverse. root_ holds the root's own opposite label by hub rank.
+        template<bool reverse>
+        void search(Vertex root, Vertex rank) {
+            auto& labels = reverse ? forward_ : backward_;
+            auto& own    = reverse ? backward_[root] : forward_[root];
+            for (auto [hub, distance] : own)
+                root_[hub] = distance;
+
+            auto arcs = [&](Vertex u, auto&& relax) {
+                double distance = tree_.distance(u);
+                for (auto [hub, known] : labels[u])
+                    if (root_[hub] + known <= distance) return;  // pruned
+                labels[u].emplace_back(rank, distance);
+                auto arc = [&](Vertex v) {
+                    auto &from = graph_.point(u), &to = graph_.point(v);
+                    relax(v, reverse ? metric_(to, from) : metric_(from, to));
+                };
+                if (reverse)
+                    graph_.forEachIncoming(u, arc);
+                else
+                    graph_.forEachNeighbour(u, arc);
+            };
+            graphs::search(graph_, std::views::single(root), arcs, graphs::noPotential,
+                           graphs::noGoal, tree_);
+
+            for (auto [hub, distance] : own)
+                root_[hub] = infinity;
+        }
+
+        const CompactGraph& graph_;
+        metrics::Metric metric_;
+        std::vector<std::vector<Entry>> forward_, backward_;
+        std::vector<double> root_;
+        SearchTree tree_;
+    };
+
+}  // namespace
+
+HubLabels::HubLabels(const CompactGraph& graph, ThreadPool* pool) {
+    bind(graph);
+    if (graph.size() == 0) return;
+
+    auto build = [this, &graph](PathType type) {
+        auto metric = Map::metricOf(type);
+        auto byRank = Contraction(graph, metric).order();
+        auto [forward, backward] = Labeling(graph, metric).run(byRank);
+        auto& table = tables_[indexOf(type)];
+        for (Vertex v = 0; v < graph.size(); v++) {
+            table.forward.append(v, forward[v]);
+            table.backward.append(v, backward[v]);
+        }
+    };
+    if (!pool) {
+        build(PathType::Pedestrian);
+        build(PathType::Car);
+        return;
+    }
+    auto car = pool->submit([&build] { build(PathType::Car); });
+    build(PathType::Pedestrian);
+    car.get();
+}
+
+bool HubLabels::empty() const noexcept {
+    return size_ == 0;
+}
+
+// the labels are only meaningful for the snapshot they were computed or loaded for
+bool HubLabels::fits(const CompactGraph& graph) const noexcept {
+    return !empty() && generation_ == graph.generation() && order_ == graph.order()
+        && size_ == graph.size();
+}
+
+// Merge join of the forward label of the source with the backward label of the target, the
+// sentinel is the largest rank so neither runs past its end. Infinity when unreachable.
+double HubLabels::distance(Vertex source, Vertex target, PathType type) const noexcept {
+    auto& table = tables_[indexOf(type)];
+    auto from   = table.forward.offsets[source];
+    auto to     = table.backward.offsets[target];
+    auto* hubsA = table.forward.hubs.data() + from;
+    auto* hubsB = table.backward.hubs.data() + to;
+    auto* distA = table.forward.distances.data() + from;
+    auto* distB = table.backward.distances.data() + to;
+
+    double result = infinity;
+    for (std::size_t i = 0, j = 0;;) {
+        auto a = hubsA[i], b = hubsB[j];
+        if (a == b) {
+            if (a == CompactGraph::nvtx) break;
+            result = std::min(result, distA[i++] + distB[j++]);
+        }
+        else if (a < b)
+            i++;
+        else
+            j++;
+    }
+    return result;
+}
+
+std::size_t HubLabels::entries() const noexcept {
+    std::size_t count {};
+    for (auto& table : tables_)
+        for (auto* labels : {&table.forward, &table.backward})
+            count += static_cast<std::size_t>(std::ranges::count_if(
+                labels->hubs, [](Vertex hub) { return hub != CompactGraph::nvtx; }));
+    return count;
+}
+
+// Binary, native byte order. Labels are stored by ascending PointId, unpadded, and the header
+// carries a fingerprint of the road network, so a file loads into any vertex order of the map.
+void HubLabels::write(std::ostream& out, const CompactGraph& graph) const {
+    std::vector<Vertex> byId(graph.size());
+    std::iota(byId.begin(), byId.end(), Vertex {});
+    std::ranges::sort(byId, {}, [&graph](Vertex v) { return graph.idOf(v); });
+
+    out.write(fileMagic, sizeof(fileMagic));
+    writeValue(out, graph.fingerprint());
+    writeValue(out, static_cast<std::uint64_t>(graph.size()));
+    for (auto& table : tables_)
+        for (auto* labels : {&table.forward, &table.backward})
+            for (auto v : byId) {
+                auto offset = labels->offsets[v];
+                auto length = static_cast<std::uint32_t>(
+                    std::find(labels->hubs.begin() + offset, labels->hubs.end(), CompactGraph::nvtx)
+                    - (labels->hubs.begin() + offset));
+                writeValue(out, length);
+                out.write(reinterpret_cast<const char*>(labels->hubs.data() + offset),
+                          static_cast<std::streamsize>(length * sizeof(Vertex)));
+                out.write(reinterpret_cast<const char*>(labels->distances.data() + offset),
+                          static_cast<std::streamsize>(length * sizeof(double)));
+            }
+}
+
+// false (and unchanged) when the stream does not hold hub labels of this road network
+bool HubLabels::read(std::istream& in, const CompactGraph& graph) {
+    char magic[sizeof(fileMagic)];
+    std::uint64_t fingerprint {}, size {};
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, fileMagic, sizeof(magic)) != 0)
+        return false;
+    if (!readValue(in, fingerprint) || !readValue(in, size)) return false;
+    if (fingerprint != graph.fingerprint() || size != graph.size()) return false;
+
+    std::vector<Vertex> byId(graph.size());
+    std::iota(byId.begin(), byId.end(), Vertex {});
+    std::ranges::sort(byId, {}, [&graph](Vertex v) { return graph.idOf(v); });
+
+    HubLabels loaded;
+    std::vector<Vertex> hubs;
+    std::vector<double> distances;
+    std::vector<Entry> label;
+    for (auto& table : loaded.tables_)
+        for (auto* labels : {&table.forward, &table.backward})
+            for (auto v : byId) {
+                std::uint32_t length {};
+                if (!readValue(in, length) || length > graph.size()) return false;
+                hubs.resize(length);
+                distances.resize(length);
+                in.read(reinterpret_cast<char*>(hubs.data()),
+                        static_cast<std::streamsize>(length * sizeof(Vertex)));
+                in.read(reinterpret_cast<char*>(distances.data()),
+                        static_cast<std::streamsize>(length * sizeof(double)));
+                if (!in) return false;
+                if (std::ranges::adjacent_find(hubs, std::greater_equal {}) != hubs.end()
+                    || (length && hubs.back() >= graph.size()))
+                    return false;
+
+                label.clear();
+                for (std::uint32_t i = 0; i < length; i++)
+                    label.emplace_back(hubs[i], distances[i]);
+                labels->append(v, label);
+            }
+
+    loaded.bind(graph);
+    *this = std::move(loaded);
+    return true;
+}
+
+// label of v after the ones appended so far, padded with sentinels to whole cache lines
+void HubLabels::Labels::append(Vertex v, const std::vector<Entry>& label) {
+    if (offsets.size() <= v) offsets.resize(v + 1);
+    offsets[v]  = static_cast<std::uint32_t>(hubs.size());
+    auto padded = (label.size() / lineEntries + 1) * lineEntries;
+    for (auto [hub, distance] : label) {
+        hubs.push_back(hub);
+        distances.push_back(distance);
+    }
+    hubs.resize(hubs.size() + padded - label.size(), CompactGraph::nvtx);
+    distances.resize(distances.size() + padded - label.size(), infinity);
+}
+
+std::size_t HubLabels::indexOf(PathType type) noexcept {
+    return static_cast<std::size_t>(type);
+}
+
+void HubLabels::bind(const CompactGraph& graph) noexcept {
+    generation_ = graph.generation();
+    order_      = graph.order();
+    size_       = graph.size();
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <new>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include "CompactGraph.h"
+#include "Path.h"
+#include "ThreadPool.h"
+
+namespace citymap
+{
+
+    /**
+     * Hub labeling distance oracle for both path types.
+     *
+     * Every vertex v has a forward label, hubs h with d(v, h), and a backward label, hubs with
+     * d(h, v), such that some shortest s-t path passes a hub in both the forward label of s and
+     * the backward label of t. A distance is then a merge join of two labels, no search at all.
+     *
+     * Hubs are ranked by a contraction hierarchy order (least important contracted first) and the
+     * labels are built by pruned searches from the most important vertex down. Hub ranks are
+     * ascending within a label, which is padded with a sentinel to whole cache lines and starts
+     * 64-byte aligned. Labels carry no routes, only distances. They belong to one CompactGraph
+     * snapshot.
+     */
+    class HubLabels {
+    public:
+        using Vertex = CompactGraph::Vertex;
+        using Entry  = std::pair<Vertex, double>;  // hub rank, distance
+
+        HubLabels() = default;
+        explicit HubLabels(const CompactGraph&, ThreadPool* = nullptr);
+        ~HubLabels() = default;
+
+        bool empty() const noexcept;
+        bool fits(const CompactGraph&) const noexcept;
+        double distance(Vertex, Vertex, PathType) const noexcept;
+        std::size_t entries() const noexcept;  // hubs over all labels, sentinels not counted
+
+        void write(std::ostream&, const CompactGraph&) const;
+        bool read(std::istream&, const CompactGraph&);
+
+    private:
+        template<typename T>
+        struct CacheAligned {
+            using value_type = T;
+
+            CacheAligned() = default;
+            template<typename U>
+            CacheAligned(const CacheAligned<U>&) noexcept {}
+
+            T* allocate(std::size_t n) {
+                return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t {64}));
+            }
+
+            void deallocate(T* p, std::size_t) noexcept {
+                ::operator delete(p, std::align_val_t {64});
+            }
+
+            bool operator==(const CacheAligned&) const = default;
+        };
+
+        // the labels of every vertex in one direction, label v starts at offsets[v]
+        struct Labels {
+            std::vector<std::uint32_t> offsets;
+            std::vector<Vertex, CacheAligned<Vertex>> hubs;  // rank, ends with a sentinel (nvtx)
+            std::vector<double, CacheAligned<double>> distances;
+
+            void append(Vertex, const std::vector<Entry>&);
+        };
+
+        struct Table {
+            Labels forward;   // d(v, hub)
+            Labels backward;  // d(hub, v)
+        };
+
+        static std::size_t indexOf(PathType) noexcept;
+
+        void bind(const CompactGraph&) noexcept;
+
+        std::array<Table, 2> tables_;
+        std::uint64_t generation_ {};
+        VertexOrder order_ {};
+        std::size_t size_ {};
+    };
+
+}  // namespace citymap
\ No newline at end of file
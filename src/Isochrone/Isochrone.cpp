@@ -0,0 +1,22 @@
+#include "Isochrone.h"
+
+using namespace citymap;
+
+Isochrone::Isochrone(PointId centre, double budget, PathType type)
+    : centre_(centre), budget_(budget), type_(type) {}
+
+PointId Isochrone::centre() const noexcept {
+    return centre_;
+}
+
+double Isochrone::budget() const noexcept {
+    return budget_;
+}
+
+PathType Isochrone::type() const noexcept {
+    return type_;
+}
+
+const std::vector<Isochrone::Reached>& Isochrone::points() const noexcept {
+    return points_;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+
+#include "Path.h"
+#include "Point.h"
+
+namespace citymap
+{
+
+    // Points reachable from a centre within a distance budget, in ascending distance.
+    class Isochrone {
+    public:
+        struct Reached {
+            PointId id;
+            double distance;
+        };
+
+        Isochrone(PointId, double, PathType);
+        ~Isochrone() = default;
+
+        PointId centre() const noexcept;
+        double budget() const noexcept;
+        PathType type() const noexcept;
+        const std::vector<Reached>& points() const noexcept;
+
+    private:
+        PointId centre_;
+        double budget_;
+        PathType type_;
+        std::vector<Reached> points_;
+
+        friend class Map;
+    };
+
+}  // namespace citymap
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include "KShortestPaths.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <set>
+#include <utility>
+
+using namespace citymap;
+
+static constexpr double infinity = std::numeric_limits<double>::infinity();
+
+// Up to k routes from source to target in ascending distance, the first is a shortest path.
+std::vector<KShortestPaths::Route> KShortestPaths::find(const CompactGraph& graph, Vertex source,
+                                                        Vertex target, std::size_t k,
+                                                        metrics::Metric metric) {
+    std::vector<Route> found;
+    if (k == 0 || source >= graph.size() || target >= graph.size()) return found;
+    graphs::search(graph, std::views::single(target), graph.incomingArcs(metric),
+                   graphs::noPotential, graphs::noGoal, tree_);
+    if (!tree_.reached(source)) return found;
+    if (blocked_.size() != graph.size()) {
+        blocked_.assign(graph.size(), 0);
+        round_ = 0;
+    }
+
+    nextRound();  // nothing blocked
+    blockedNext_.clear();
+    found.push_back({tree_.distance(source), {}});
+    treePath(source, found.back().vertices);
+
+    auto longer = [](const Route& a, const Route& b) { return a.distance > b.distance; };
+    std::vector<Route> candidates;  // min-heap on distance
+    std::set<std::vector<Vertex>> seen {found.back().vertices};
+    std::vector<Vertex> spurPath;
+    while (found.size() < k) {
+        const auto& last = found.back();
+        double rootDistance {};
+        for (std::size_t i = 0; i + 1 < last.vertices.size(); i++) {
+            block(found, last, i);
+            if (double distance = spur(graph, last.vertices[i], target, metric, spurPath);
+                distance != infinity)
+            {
+                Route candidate {rootDistance + distance,
+                                 {last.vertices.begin(), last.vertices.begin() + i}};
+                candidate.vertices.insert(candidate.vertices.end(), spurPath.begin(),
+                                          spurPath.end());
+                if (seen.insert(candidate.vertices).second) {
+                    candidates.push_back(std::move(candidate));
+                    std::ranges::push_heap(candidates, longer);
+                }
+            }
+            auto [u, v] = std::pair(last.vertices[i], last.vertices[i + 1]);
+            rootDistance += metric(graph.point(u), graph.point(v));
+        }
+        if (candidates.empty()) break;
+        std::ranges::pop_heap(candidates, longer);
+        found.push_back(std::move(candidates.back()));
+        candidates.pop_back();
+    }
+    return found;
+}
+
+// Blocks the root of last before its i-th vertex, and the arcs leaving that vertex
+// along every route found so far sharing this root.
+void KShortestPaths::block(const std::vector<Route>& found, const Route& last, std::size_t i) {
+    nextRound();
+    for (std::size_t j = 0; j < i; j++)
+        blocked_[last.vertices[j]] = round_;
+
+    blockedNext_.clear();
+    for (auto& route : found)
+        if (route.vertices.size() > i + 1
+            && std::ranges::equal(route.vertices.begin(), route.vertices.begin() + i + 1,
+                                  last.vertices.begin(), last.vertices.begin() + i + 1))
+            blockedNext_.push_back(route.vertices[i + 1]);
+}
+
+// Path from v to the target along the reverse tree, false when it runs into anything blocked.
+bool KShortestPaths::treePath(Vertex v, std::vector<Vertex>& path) const {
+    path.assign(1, v);
+    auto next = tree_.parent(v);
+    if (!next) return false;
+    if (*next != v && blockedArc(*next)) return false;
+    for (; *next != v; v = *next, next = tree_.parent(v)) {
+        if (blocked_[*next] == round_) return false;
+        path.push_back(*next);
+    }
+    return true;
+}
+
+// Shortest path from the spur vertex to the target avoiding everything blocked,
+// infinity when there is none.
+double KShortestPaths::spur(const CompactGraph& graph, Vertex from, Vertex target,
+                            metrics::Metric metric, std::vector<Vertex>& path) {
+    if (treePath(from, path)) return tree_.distance(from);
+
+    auto arcs = [&](Vertex u, auto&& relax) {
+        graph.forEachNeighbour(u, [&](Vertex v) {
+            if (blocked_[v] == round_) return;
+            if (u == from && blockedArc(v)) return;
+            relax(v, metric(graph.point(u), graph.point(v)));
+        });
+    };
+    auto potential = [this](Vertex v) { return tree_.distance(v); };
+    graphs::search(graph, std::views::single(from), arcs, potential,
+                   [target](Vertex u) { return u == target; }, spur_);
+    path = spur_.path(target);
+    return spur_.distance(target);
+}
+
+// whether the arc from the spur vertex to head is blocked
+bool KShortestPaths::blockedArc(Vertex head) const noexcept {
+    return std::ranges::find(blockedNext_, head) != blockedNext_.end();
+}
+
+// unblocks every vertex
+void KShortestPaths::nextRound() {
+    if (++round_ == 0) {
+        std::ranges::fill(blocked_, 0);
+        round_ = 1;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "CompactGraph.h"
+#include "metrics.h"
+
+namespace citymap
+{
+
+    /**
+     * k shortest loopless paths (Yen).
+     *
+     * A single reverse search from the target gives every vertex its distance to it. A spur whose
+     * path along that tree avoids the blocked root and arcs is read off the tree, any other spur
+     * is an A* search guided by the tree distances, exact lower bounds since blocking only removes
+     * arcs. All searches reuse the workspaces of the engine, so keep one per thread.
+     */
+    class KShortestPaths {
+    public:
+        using Vertex = CompactGraph::Vertex;
+
+        struct Route {
+            double distance;
+            std::vector<Vertex> vertices;
+        };
+
+        KShortestPaths()  = default;
+        ~KShortestPaths() = default;
+
+        std::vector<Route> find(const CompactGraph&, Vertex, Vertex, std::size_t, metrics::Metric);
+
+    private:
+        void nextRound();
+        void block(const std::vector<Route>&, const Route&, std::size_t);
+        bool blockedArc(Vertex) const noexcept;
+        bool treePath(Vertex, std::vector<Vertex>&) const;
+        double spur(const CompactGraph&, Vertex, Vertex, metrics::Metric, std::vector<Vertex>&);
+
+        SearchTree tree_;
+        SearchTree spur_;
+        std::vector<std::uint32_t> blocked_;  // round a vertex was last blocked in
+        std::uint32_t round_ {};
+        std::vector<Vertex> blockedNext_;  // heads of the blocked arcs leaving the spur vertex
+    };
+
+}  // namespace citymap
\ No newline at end of file
@@ -0,0 +1,262 @@
+#include "Landmarks.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+#include "Map.h"
+
+using namespace citymap;
+
+static constexpr char fileMagic[8] = {'C', 'I', 'T', 'Y', 'A', 'L', 'T', '1'};
+
+static constexpr float infinity = std::numeric_limits<float>::infinity();
+
+// bound on the rounding error of a difference of two stored float distances, relative to their sum
+static constexpr float tolerance = 2 * std::numeric_limits<float>::epsilon();
+
+template<typename T>
+static void writeValue(std::ostream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template<typename T>
+static bool readValue(std::istream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+// far - near rounded down, so the bound stays admissible despite float storage
+static float boundOf(float far, float near) noexcept {
+    float diff = far - near;
+    return std::isfinite(diff) ? diff - (far + near) * tolerance : diff;
+}
+
+Landmarks::Landmarks(const CompactGraph& graph, std::size_t count, ThreadPool* pool) {
+    bind(graph);
+    count = std::min({count, maxCount, graph.size()});
+    if (count == 0) return;
+
+    vertices_.assign(count, CompactGraph::nvtx);
+    for (auto& table : tables_) {
+        table.from.assign(graph.size() * count, infinity);
+        table.to.assign(graph.size() * count, infinity);
+    }
+
+    // farthest point selection over pedestrian distances, the first landmark is the vertex
+    // farthest from vertex 0, unreachable vertices count as the farthest
+    SearchTree tree;
+    graphs::dijkstra(graph, Vertex {}, graph.weight(metrics::euclidean), std::nullopt, tree);
+    Vertex first {};
+    for (Vertex v = 0; v < graph.size(); v++)
+        if (std::isfinite(tree.distance(v)) && tree.distance(v) > tree.distance(first))
+            first = v;
+
+    std::vector<float> nearest(graph.size(), infinity);
+    for (std::size_t i = 0; i < count; i++) {
+        auto farthest = std::ranges::max_element(nearest) - nearest.begin();
+        vertices_[i]  = i == 0 ? first : static_cast<Vertex>(farthest);
+        fill(graph, i, PathType::Pedestrian, true, tree);
+
+        auto& from = tables_[indexOf(PathType::Pedestrian)].from;
+        for (Vertex v = 0; v < graph.size(); v++)
+            nearest[v] = std::min(nearest[v], from[v * count + i]);
+    }
+
+    // the remaining tables are independent of each other
+    auto remaining = [this, &graph](std::size_t i) {
+        SearchTree tree;
+        fill(graph, i, PathType::Pedestrian, false, tree);
+        fill(graph, i, PathType::Car, true, tree);
+        fill(graph, i, PathType::Car, false, tree);
+    };
+    if (!pool) {
+        for (std::size_t i = 0; i < count; i++)
+            remaining(i);
+        return;
+    }
+    std::vector<std::future<void>> tasks;
+    for (std::size_t i = 0; i < count; i++)
+        tasks.push_back(pool->submit([&remaining, i] { remaining(i); }));
+    for (auto& task : tasks)
+        task.get();
+}
+
+// Repairs previous for graph, a patch of its snapshot with the inserted arcs added and maybe others
+// removed. The triangle inequality the bounds rest on still holds over the remaining arcs after a
+// removal, the stored distances just bound less tightly. An inserted arc can break it at its head
+// (its tail for the distances to a landmark), so those are lowered and the decrease propagated.
+Landmarks::Landmarks(const Landmarks& previous, const CompactGraph& graph,
+                     std::span<const std::pair<Vertex, Vertex>> inserted)
+    : vertices_(previous.vertices_), tables_(previous.tables_) {
+    bind(graph);
+    if (inserted.empty()) return;
+    for (std::size_t i = 0; i < count(); i++)
+        for (auto type : {PathType::Pedestrian, PathType::Car}) {
+            lower(graph, i, type, true, inserted);
+            lower(graph, i, type, false, inserted);
+        }
+}
+
+std::size_t Landmarks::count() const noexcept {
+    return vertices_.size();
+}
+
+bool Landmarks::empty() const noexcept {
+    return vertices_.empty();
+}
+
+// the tables are only meaningful for the snapshot they were computed or loaded for
+bool Landmarks::fits(const CompactGraph& graph) const noexcept {
+    return !empty() && generation_ == graph.generation() && order_ == graph.order()
+        && size_ == graph.size();
+}
+
+const std::vector<Landmarks::Vertex>& Landmarks::vertices() const noexcept {
+    return vertices_;
+}
+
+// infinity when v provably cannot reach t
+double Landmarks::lowerBound(Vertex v, Vertex t, PathType type) const noexcept {
+    auto& table  = tables_[indexOf(type)];
+    auto k       = count();
+    auto* fromV  = table.from.data() + v * k;
+    auto* fromT  = table.from.data() + t * k;
+    auto* toV    = table.to.data() + v * k;
+    auto* toT    = table.to.data() + t * k;
+    float result = 0.0f;
+    for (std::size_t i = 0; i < k; i++) {
+        // comparisons are false for NaN (both unreachable), those landmarks say nothing
+        if (float bound = boundOf(fromT[i], fromV[i]); bound > result) result = bound;
+        if (float bound = boundOf(toV[i], toT[i]); bound > result) result = bound;
+    }
+    return result;
+}
+
+// Binary, native byte order. Rows are stored by ascending PointId and the header carries a
+// fingerprint of the road network, so a file loads into any vertex order of the same map.
+void Landmarks::write(std::ostream& out, const CompactGraph& graph) const {
+    std::vector<Vertex> byId(graph.size());
+    std::iota(byId.begin(), byId.end(), Vertex {});
+    std::ranges::sort(byId, {}, [&graph](Vertex v) { return graph.idOf(v); });
+
+    out.write(fileMagic, sizeof(fileMagic));
+    writeValue(out, graph.fingerprint());
+    writeValue(out, static_cast<std::uint64_t>(graph.size()));
+    writeValue(out, static_cast<std::uint64_t>(count()));
+    for (auto landmark : vertices_)
+        writeValue(out, static_cast<std::uint64_t>(graph.idOf(landmark)));
+
+    auto rowSize = static_cast<std::streamsize>(count() * sizeof(float));
+    for (auto& table : tables_)
+        for (auto* column : {&table.from, &table.to})
+            for (auto v : byId)
+                out.write(reinterpret_cast<const char*>(column->data() + v * count()), rowSize);
+}
+
+// false (and unchanged) when the stream does not hold landmarks of this road network
+bool Landmarks::read(std::istream& in, const CompactGraph& graph) {
+    char magic[sizeof(fileMagic)];
+    std::uint64_t fingerprint {}, size {}, count {};
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, fileMagic, sizeof(magic)) != 0)
+        return false;
+    if (!readValue(in, fingerprint) || !readValue(in, size) || !readValue(in, count)) return false;
+    if (fingerprint != graph.fingerprint() || size != graph.size() || count > maxCount)
+        return false;
+
+    Landmarks loaded;
+    for (std::uint64_t i = 0, id; i < count; i++) {
+        if (!readValue(in, id)) return false;
+        auto landmark = graph.vertexOf(id);
+        if (landmark == CompactGraph::nvtx) return false;
+        loaded.vertices_.push_back(landmark);
+    }
+
+    std::vector<Vertex> byId(graph.size());
+    std::iota(byId.begin(), byId.end(), Vertex {});
+    std::ranges::sort(byId, {}, [&graph](Vertex v) { return graph.idOf(v); });
+
+    auto rowSize = static_cast<std::streamsize>(count * sizeof(float));
+    for (auto& table : loaded.tables_)
+        for (auto* column : {&table.from, &table.to}) {
+            column->resize(graph.size() * count);
+            for (auto v : byId)
+                if (!in.read(reinterpret_cast<char*>(column->data() + v * count), rowSize))
+                    return false;
+        }
+
+    loaded.bind(graph);
+    *this = std::move(loaded);
+    return true;
+}
+
+std::size_t Landmarks::indexOf(PathType type) noexcept {
+    return static_cast<std::size_t>(type);
+}
+
+// writes column i of a table: distances from (forward) or to landmark i
+void Landmarks::fill(const CompactGraph& graph, std::size_t i, PathType type, bool forward,
+                     SearchTree& tree) {
+    auto metric = Map::metricOf(type);
+    auto source = std::views::single(vertices_[i]);
+    if (forward)
+        graphs::search(graph, source, graph.arcs(metric), graphs::noPotential, graphs::noGoal,
+                       tree);
+    else
+        graphs::search(graph, source, graph.incomingArcs(metric), graphs::noPotential,
+                       graphs::noGoal, tree);
+
+    auto& column = forward ? tables_[indexOf(type)].from : tables_[indexOf(type)].to;
+    for (Vertex v = 0; v < graph.size(); v++)
+        column[v * count() + i] = static_cast<float>(tree.distance(v));
+}
+
+// Lowers column i of a table across the inserted arcs and onwards in Dijkstra order, until every
+// arc satisfies the triangle inequality again. Only the vertices whose distance drops are visited.
+void Landmarks::lower(const CompactGraph& graph, std::size_t i, PathType type, bool forward,
+                      std::span<const std::pair<Vertex, Vertex>> inserted) {
+    using Entry  = std::pair<double, Vertex>;
+    auto metric  = Map::metricOf(type);
+    auto& column = forward ? tables_[indexOf(type)].from : tables_[indexOf(type)].to;
+    auto k       = count();
+    std::vector<Entry> heap;
+    auto relax = [&](Vertex v, double distance) {
+        auto& stored = column[v * k + i];
+        if (static_cast<float>(distance) >= stored) return;
+        stored = static_cast<float>(distance);
+        heap.push_back({distance, v});
+        std::ranges::push_heap(heap, std::greater {});
+    };
+
+    for (auto [a, b] : inserted) {
+        auto length = metric(graph.point(a), graph.point(b));
+        if (forward)
+            relax(b, column[a * k + i] + length);
+        else
+            relax(a, column[b * k + i] + length);
+    }
+    while (!heap.empty()) {
+        std::ranges::pop_heap(heap, std::greater {});
+        auto [distance, u] = heap.back();
+        heap.pop_back();
+        if (static_cast<float>(distance) > column[u * k + i]) continue;  // stale entry
+        if (forward)
+            graph.forEachNeighbour(u, [&](Vertex v) {
+                relax(v, distance + metric(graph.point(u), graph.point(v)));
+            });
+        else
+            graph.forEachIncoming(u, [&](Vertex v) {
+                relax(v, distance + metric(graph.point(v), graph.point(u)));
+            });
+    }
+}
+
+void Landmarks::bind(const CompactGraph& graph) noexcept {
+    generation_ = graph.generation();
+    order_      = graph.order();
+    size_       = graph.size();
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "CompactGraph.h"
+#include "Path.h"
+#include "ThreadPool.h"
+
+namespace citymap
+{
+
+    /**
+     * ALT preprocessing: distances from and to a few landmarks, for both path types.
+     *
+     * By the triangle inequality d(v, t) >= d(L, t) - d(L, v) and d(v, t) >= d(v, L) - d(t, L),
+     * the largest of these over all landmarks is the A* potential of a query to t.
+     * Landmarks are picked by farthest point selection, the tables are float32 and vertex major
+     * (the bounds of one vertex share a cache line). They belong to one CompactGraph snapshot,
+     * and are repaired for a patch of it whose connections changed.
+     */
+    class Landmarks {
+    public:
+        using Vertex = CompactGraph::Vertex;
+
+        static constexpr std::size_t defaultCount = 16;
+        static constexpr std::size_t maxCount     = 64;
+
+        Landmarks() = default;
+        Landmarks(const CompactGraph&, std::size_t = defaultCount, ThreadPool* = nullptr);
+        Landmarks(const Landmarks&, const CompactGraph&,
+                  std::span<const std::pair<Vertex, Vertex>>);
+        ~Landmarks() = default;
+
+        std::size_t count() const noexcept;
+        bool empty() const noexcept;
+        bool fits(const CompactGraph&) const noexcept;
+        const std::vector<Vertex>& vertices() const noexcept;
+        double lowerBound(Vertex, Vertex, PathType) const noexcept;
+
+        void write(std::ostream&, const CompactGraph&) const;
+        bool read(std::istream&, const CompactGraph&);
+
+    private:
+        struct Table {
+            std::vector<float> from;  // d(L, v)
+            std::vector<float> to;    // d(v, L)
+        };
+
+        static std::size_t indexOf(PathType) noexcept;
+
+        void fill(const CompactGraph&, std::size_t, PathType, bool, SearchTree&);
+        void lower(const CompactGraph&, std::size_t, PathType, bool,
+                   std::span<const std::pair<Vertex, Vertex>>);
+        void bind(const CompactGraph&) noexcept;
+
+        std::vector<Vertex> vertices_;
+        std::array<Table, 2> tables_;
+        std::uint64_t generation_ {};
+        VertexOrder order_ {};
+        std::size_t size_ {};
+    };
+
+}  // namespace citymap
\ No newline at end of file
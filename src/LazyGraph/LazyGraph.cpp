@@ -0,0 +1,143 @@
+#include "LazyGraph.h"
+
+#include <algorithm>
+#include <charconv>
+#include <limits>
+#include <stdexcept>
+
+using namespace citymap;
+
+static constexpr bool isBlank(char c) noexcept {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Non-blank lines of the matrix, a scan for line breaks without parsing any cell.
+LazyGraph::LazyGraph(MappedFile file, const std::filesystem::path& path,
+                     const std::vector<PointId>& ids, const Map& map)
+    : file_(std::move(file)), path_(path.string()), ids_(ids) {
+    std::string_view text = file_.view();
+    std::size_t number {};
+    while (!text.empty() && lines_.size() < ids_.size()) {
+        auto nl   = text.find('\n');
+        auto line = text.substr(0, nl);
+        text      = nl == std::string_view::npos ? std::string_view() : text.substr(nl + 1);
+        number++;
+        if (line.find_first_not_of(" \t\r") != std::string_view::npos)
+            lines_.push_back({line, number});
+    }
+
+    points_.reserve(ids_.size());
+    categories_.reserve(ids_.size());
+    rows_.reserve(ids_.size());
+    for (Row r = 0; r < ids_.size(); r++) {
+        points_.push_back(map.valueOf(ids_[r]));
+        categories_.push_back(map.categoryOf(ids_[r]));
+        rows_.emplace(ids_[r], r);
+    }
+    adjacency_.resize(ids_.size());
+    decoded_.resize(ids_.size());
+}
+
+// matrix rows found, fewer than points means the file is truncated
+std::size_t LazyGraph::rows() const noexcept {
+    return lines_.size();
+}
+
+// rows parsed so far
+std::size_t LazyGraph::decoded() const noexcept {
+    return decodedCount_;
+}
+
+// Point to point and multi-stop routes (legs searched one after another) and the closest facility
+// from a point. Routing every point to a facility needs the whole matrix and is not supported.
+PathPtr LazyGraph::findPath(const Query& query) {
+    auto metric = Map::metricOf(query.type());
+    Path::PointList points;
+    double distance = 0.0;
+
+    if (query.nearest() != Map::ncat) {
+        if (query.from() == Map::npnt)
+            throw std::invalid_argument("LazyGraph: nearest: from every point needs all rows");
+        auto goal = [this, category = query.nearest()](Row r) {
+            return categories_[r] == category;
+        };
+        if (auto found = search(rowOf(query.from()), goal, metric); found != nrow) {
+            distance = tree_.distance(found);
+            appendPath(found, points);
+        }
+    }
+    else {
+        auto stops = query.stops();
+        for (std::size_t leg = 0; leg + 1 < stops.size(); leg++) {
+            auto target = rowOf(stops[leg + 1]);
+            auto found  = search(rowOf(stops[leg]), [target](Row r) { return r == target; },
+                                 metric);
+            if (found == nrow) {
+                points.clear();
+                break;
+            }
+            distance += tree_.distance(found);
+            if (leg) points.pop_back();  // the stop ending the previous leg
+            appendPath(found, points);
+        }
+    }
+
+    if (points.empty()) distance = std::numeric_limits<double>::infinity();
+    auto* resource = std::pmr::get_default_resource();
+    auto path      = query.type() == PathType::Car
+                         ? makePath<CarPath>(resource, distance, std::move(points))
+                         : makePath<PedestrianPath>(resource, distance, std::move(points));
+    path->endpoints(query.from(), query.to());
+    return path;
+}
+
+LazyGraph::Row LazyGraph::rowOf(PointId id) const {
+    auto it = rows_.find(id);
+    if (it == rows_.end()) throw std::out_of_range("LazyGraph: unknown point");
+    return it->second;
+}
+
+// parses the row on first use, same rules as the eager loader
+const std::vector<LazyGraph::Row>& LazyGraph::neighbours(Row r) {
+    auto& targets = adjacency_[r];
+    if (decoded_[r]) return targets;
+
+    const char* it  = lines_[r].text.data();
+    const char* end = it + lines_[r].text.size();
+    for (Row column = 0; column < ids_.size(); column++) {
+        while (it < end && isBlank(*it))
+            it++;
+        unsigned value;
+        auto [next, ec] = std::from_chars(it, end, value);
+        if (ec != std::errc {} || value > 1)
+            throw std::runtime_error("An error occured while reading file: " + path_
+                                     + "\n Invalid or missing value(s) on line: "
+                                     + std::to_string(lines_[r].number));
+        if (value && column != r) targets.push_back(column);
+        it = next;
+    }
+    decoded_[r] = true;
+    decodedCount_++;
+    return targets;
+}
+
+// Dijkstra from the source until goal(r) holds for a settled row, returns it or nrow.
+template<typename Goal>
+LazyGraph::Row LazyGraph::search(Row source, Goal goal, metrics::Metric metric) {
+    auto arcs = [this, metric](Row u, auto&& relax) {
+        for (auto v : neighbours(u))
+            relax(v, metric(points_[u], points_[v]));
+    };
+    auto found = graphs::search(Rows {this}, std::views::single(source), arcs,
+                                graphs::noPotential, goal, tree_);
+    return found.value_or(nrow);
+}
+
+// points of the last search from its source to r, appended
+void LazyGraph::appendPath(Row r, Path::PointList& points) const {
+    auto first = points.size();
+    for (; *tree_.parent(r) != r; r = *tree_.parent(r))
+        points.push_back(ids_[r]);
+    points.push_back(ids_[r]);
+    std::reverse(points.begin() + static_cast<std::ptrdiff_t>(first), points.end());
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "MappedFile.h"
+#include "algorithms.h"
+#include "Map.h"
+#include "Path.h"
+#include "Query.h"
+#include "metrics.h"
+
+namespace citymap
+{
+
+    /**
+     * Road network read on demand from a memory-mapped connections matrix.
+     *
+     * Only the row starts are indexed up front. A row is parsed the first time a search settles
+     * its point and is cached afterwards, so a few queries only pay for the part of the file they
+     * explore. Searches share the cache and must not run concurrently.
+     */
+    class LazyGraph {
+    public:
+        LazyGraph(MappedFile, const std::filesystem::path&, const std::vector<PointId>&,
+                  const Map&);
+        ~LazyGraph() = default;
+
+        std::size_t rows() const noexcept;
+        std::size_t decoded() const noexcept;
+        PathPtr findPath(const Query&);
+
+    private:
+        using Row = std::uint32_t;
+
+        static constexpr Row nrow = static_cast<Row>(-1);
+
+        struct Line {
+            std::string_view text;
+            std::size_t number;
+        };
+
+        // the rows as a graph of graphs::search, parsed when it asks for their adjacency
+        struct Rows {
+            using vertex_type                    = Row;
+            static constexpr bool dense_vertices = true;
+
+            std::size_t size() const noexcept { return self->ids_.size(); }
+            std::span<const Row> adjacent(Row r) const { return self->neighbours(r); }
+            std::ranges::iota_view<Row, Row> vertices() const {
+                return std::views::iota(Row {}, static_cast<Row>(size()));
+            }
+
+            LazyGraph* self;
+        };
+
+        Row rowOf(PointId) const;
+        const std::vector<Row>& neighbours(Row);
+        template<typename Goal>
+        Row search(Row, Goal, metrics::Metric);
+        void appendPath(Row, Path::PointList&) const;
+
+        MappedFile file_;
+        std::string path_;
+        std::vector<Line> lines_;
+        std::vector<PointId> ids_;
+        std::vector<Point> points_;
+        std::vector<CategoryId> categories_;
+        std::unordered_map<PointId, Row> rows_;
+        std::vector<std::vector<Row>> adjacency_;
+        std::vector<bool> decoded_;
+        std::size_t decodedCount_ {};
+        graphs::SearchTree<Rows, double> tree_;
+    };
+
+}  // namespace citymap
\ No newline at end of file
@@ -0,0 +1,316 @@
+#include "CompactGraph.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+#include "Map.h"
+
+using namespace citymap;
+
+static constexpr std::uint32_t hilbertSide = 1u << 16;
+
+// distance of (x, y) along a Hilbert curve filling a hilbertSide^2 grid
+static std::uint64_t hilbertIndex(std::uint32_t x, std::uint32_t y) noexcept {
+    std::uint64_t index {};
+    for (std::uint32_t s = hilbertSide / 2; s > 0; s /= 2) {
+        std::uint32_t rx = (x & s) != 0, ry = (y & s) != 0;
+        index += std::uint64_t {s} * s * ((3 * rx) ^ ry);
+        if (ry == 0) {
+            if (rx == 1) {
+                x = hilbertSide - 1 - x;
+                y = hilbertSide - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return index;
+}
+
+// splitmix64 finalizer
+static std::uint64_t mix(std::uint64_t x) noexcept {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111eb;
+    return x ^ (x >> 31);
+}
+
+// CompactGraph
+
+CompactGraph::CompactGraph(const Map& map, VertexOrder order, AdjacencyLayout adjacency)
+    : order_(order), adjacency_(adjacency), generation_(map.generation()) {
+    if (map.size() >= nvtx) throw std::length_error("CompactGraph: too many points");
+
+    ids_ = map.ids();
+    std::ranges::sort(ids_);
+    auto vertices = std::make_shared<std::unordered_map<PointId, Vertex>>();
+    vertices->reserve(ids_.size());
+    points_.reserve(ids_.size());
+    offsets_.reserve(ids_.size() + 1);
+    for (Vertex v = 0; v < ids_.size(); v++) {
+        vertices->emplace(ids_[v], v);
+        points_.push_back(map.valueOf(ids_[v]));
+    }
+    for (auto id : ids_) {
+        for (auto target : map.connectionsOf(id))
+            targets_.push_back(vertices->at(target));
+        offsets_.push_back(static_cast<std::uint32_t>(targets_.size()));
+    }
+
+    switch (order) {
+        case VertexOrder::Input: {
+            Permutation identity(size());
+            std::iota(identity.begin(), identity.end(), Vertex {});
+            permute(identity);
+            break;
+        }
+        case VertexOrder::Hilbert: permute(hilbertOrder()); break;
+        case VertexOrder::Bfs:     permute(bfsOrder(false)); break;
+        case VertexOrder::Rcm:     permute(bfsOrder(true)); break;
+    }
+    for (Vertex v = 0; v < size(); v++)
+        (*vertices)[ids_[v]] = v;
+    vertices_ = std::move(vertices);
+    reverseArcs();
+    pack();
+}
+
+// Snapshot of map after the connections of the given points changed, numbered like previous.
+// Only their lists are read from the map, the rest is copied and the PointId index is shared.
+CompactGraph::CompactGraph(const CompactGraph& previous, const Map& map,
+                           std::span<const PointId> changed)
+    : points_(previous.points_), ids_(previous.ids_), vertices_(previous.vertices_),
+      order_(previous.order_), adjacency_(previous.adjacency_), generation_(map.generation()) {
+    std::vector<bool> dirty(size());
+    for (auto id : changed)
+        dirty[vertexOf(id)] = true;
+
+    offsets_.reserve(size() + 1);
+    targets_.reserve(previous.edgeCount() + changed.size());
+    for (Vertex u = 0; u < size(); u++) {
+        auto begin = targets_.size();
+        if (dirty[u]) {
+            for (auto target : map.connectionsOf(idOf(u)))
+                targets_.push_back(vertexOf(target));
+            std::sort(targets_.begin() + begin, targets_.end());
+        }
+        else
+            previous.forEachNeighbour(u, [this](Vertex v) { targets_.push_back(v); });
+        offsets_.push_back(static_cast<std::uint32_t>(targets_.size()));
+    }
+    reverseArcs();
+    pack();
+}
+
+std::size_t CompactGraph::size() const noexcept {
+    return ids_.size();
+}
+
+std::size_t CompactGraph::edgeCount() const noexcept {
+    return edges_;
+}
+
+CompactGraph::ArcRange CompactGraph::adjacent(Vertex v) const noexcept {
+    if (adjacency_ == AdjacencyLayout::Packed)
+        return ArcRange(v, {}, packedTargets_.list(v), true);
+    return ArcRange(v, targetsOf(v), {}, false);
+}
+
+// the plain lists, only kept in that layout
+std::span<const CompactGraph::Vertex> CompactGraph::targetsOf(Vertex v) const noexcept {
+    return {targets_.data() + offsets_[v], targets_.data() + offsets_[v + 1]};
+}
+
+std::span<const CompactGraph::Vertex> CompactGraph::sourcesOf(Vertex v) const noexcept {
+    return {sources_.data() + incomingOffsets_[v], sources_.data() + incomingOffsets_[v + 1]};
+}
+
+std::ranges::iota_view<CompactGraph::Vertex, CompactGraph::Vertex>
+CompactGraph::vertices() const noexcept {
+    return std::views::iota(Vertex {0}, static_cast<Vertex>(size()));
+}
+
+const Point& CompactGraph::point(Vertex v) const noexcept {
+    return points_[v];
+}
+
+// nvtx when the point is not part of the snapshot
+CompactGraph::Vertex CompactGraph::vertexOf(PointId id) const noexcept {
+    auto it = vertices_->find(id);
+    return it == vertices_->end() ? nvtx : it->second;
+}
+
+PointId CompactGraph::idOf(Vertex v) const noexcept {
+    return ids_[v];
+}
+
+VertexOrder CompactGraph::order() const noexcept {
+    return order_;
+}
+
+AdjacencyLayout CompactGraph::adjacency() const noexcept {
+    return adjacency_;
+}
+
+// memory of the arcs the searches follow, both directions
+std::size_t CompactGraph::adjacencyBytes() const noexcept {
+    if (adjacency_ == AdjacencyLayout::Packed)
+        return packedTargets_.bytes() + packedSources_.bytes();
+    return (offsets_.size() + targets_.size() + incomingOffsets_.size() + sources_.size()) *
+           sizeof(std::uint32_t);
+}
+
+// generation of the map the snapshot was taken from
+std::uint64_t CompactGraph::generation() const noexcept {
+    return generation_;
+}
+
+// mean index distance between the endpoints of an edge, lower means better locality
+double CompactGraph::edgeSpan() const noexcept {
+    if (edges_ == 0) return 0.0;
+    double sum {};
+    for (Vertex u = 0; u < size(); u++)
+        forEachNeighbour(u, [u, &sum](Vertex v) { sum += u < v ? v - u : u - v; });
+    return sum / static_cast<double>(edges_);
+}
+
+// Identifies the road network independent of the vertex order: a sum over points and connections
+// keyed by PointId. Files of preprocessed data carry it to be loaded into any layout of the map.
+std::uint64_t CompactGraph::fingerprint() const noexcept {
+    std::uint64_t sum = mix(size()) + mix(edgeCount() + 1);
+    for (Vertex v = 0; v < size(); v++) {
+        auto id    = mix(idOf(v));
+        auto point = points_[v];
+        sum += mix(id ^ mix(static_cast<std::uint32_t>(point.x)
+                            | std::uint64_t {static_cast<std::uint32_t>(point.y)} << 32));
+        forEachNeighbour(v, [this, id, &sum](Vertex w) {
+            sum += mix(id ^ (idOf(w) * 0x9e3779b97f4a7c15));
+        });
+    }
+    return sum;
+}
+
+CompactGraph::Permutation CompactGraph::hilbertOrder() const {
+    Permutation order(size());
+    std::iota(order.begin(), order.end(), Vertex {});
+    if (order.empty()) return order;
+
+    auto [minX, maxX] = std::ranges::minmax(points_, {}, &Point::x);
+    auto [minY, maxY] = std::ranges::minmax(points_, {}, &Point::y);
+    double extent     = std::max({1.0, static_cast<double>(maxX.x) - minX.x,
+                                      static_cast<double>(maxY.y) - minY.y});
+    double scale      = (hilbertSide - 1) / extent;
+
+    std::vector<std::uint64_t> keys(size());
+    for (Vertex v = 0; v < size(); v++)
+        keys[v] = hilbertIndex(static_cast<std::uint32_t>((points_[v].x - minX.x) * scale),
+                               static_cast<std::uint32_t>((points_[v].y - minY.y) * scale));
+    std::ranges::stable_sort(order, {}, [&keys](Vertex v) { return keys[v]; });
+    return order;
+}
+
+// Breadth first over the undirected network, every component starting from a low degree
+// (likely peripheral) vertex. With cuthillMcKee the children of a vertex are queued by
+// increasing degree and the final order is reversed (RCM), which narrows the bandwidth.
+CompactGraph::Permutation CompactGraph::bfsOrder(bool cuthillMcKee) const {
+    std::vector<std::uint32_t> first(size() + 1);
+    for (Vertex u = 0; u < size(); u++)
+        for (auto v : targetsOf(u)) {
+            first[u + 1]++;
+            first[v + 1]++;
+        }
+    std::partial_sum(first.begin(), first.end(), first.begin());
+
+    std::vector<Vertex> adjacent(first.back());
+    auto fill = first;
+    for (Vertex u = 0; u < size(); u++)
+        for (auto v : targetsOf(u)) {
+            adjacent[fill[u]++] = v;
+            adjacent[fill[v]++] = u;
+        }
+    auto degree = [&first](Vertex v) { return first[v + 1] - first[v]; };
+
+    Permutation starts(size());
+    std::iota(starts.begin(), starts.end(), Vertex {});
+    std::ranges::stable_sort(starts, {}, degree);
+
+    Permutation order;
+    order.reserve(size());
+    std::vector<bool> seen(size());
+    for (auto start : starts) {
+        if (seen[start]) continue;
+        seen[start] = true;
+        order.push_back(start);
+
+        for (std::size_t head = order.size() - 1; head < order.size(); head++) {
+            Vertex u   = order[head];
+            auto begin = order.size();
+            for (auto i = first[u]; i < first[u + 1]; i++)
+                if (!seen[adjacent[i]]) {
+                    seen[adjacent[i]] = true;
+                    order.push_back(adjacent[i]);
+                }
+            if (cuthillMcKee)
+                std::stable_sort(order.begin() + begin, order.end(),
+                                 [&degree](Vertex a, Vertex b) { return degree(a) < degree(b); });
+        }
+    }
+    if (cuthillMcKee) std::ranges::reverse(order);
+    return order;
+}
+
+// order[new] = old, adjacency lists end up sorted by the new numbering
+void CompactGraph::permute(const Permutation& order) {
+    Permutation rank(size());
+    for (Vertex v = 0; v < size(); v++)
+        rank[order[v]] = v;
+
+    std::vector<std::uint32_t> offsets {0};
+    std::vector<Vertex> targets;
+    std::vector<Point> points;
+    std::vector<PointId> ids;
+    offsets.reserve(size() + 1);
+    targets.reserve(targets_.size());
+    points.reserve(size());
+    ids.reserve(size());
+    for (auto old : order) {
+        auto begin = targets.size();
+        for (auto target : targetsOf(old))
+            targets.push_back(rank[target]);
+        std::sort(targets.begin() + begin, targets.end());
+        offsets.push_back(static_cast<std::uint32_t>(targets.size()));
+        points.push_back(points_[old]);
+        ids.push_back(ids_[old]);
+    }
+
+    offsets_.swap(offsets);
+    targets_.swap(targets);
+    points_.swap(points);
+    ids_.swap(ids);
+}
+
+// reverse adjacency, sources end up sorted as well
+void CompactGraph::reverseArcs() {
+    incomingOffsets_.assign(size() + 1, 0);
+    for (auto target : targets_)
+        incomingOffsets_[target + 1]++;
+    std::partial_sum(incomingOffsets_.begin(), incomingOffsets_.end(), incomingOffsets_.begin());
+    sources_.resize(targets_.size());
+    auto fill = incomingOffsets_;
+    for (Vertex u = 0; u < size(); u++)
+        for (auto v : targetsOf(u))
+            sources_[fill[v]++] = u;
+}
+
+// the packed layout replaces the plain lists
+void CompactGraph::pack() {
+    edges_ = targets_.size();
+    if (adjacency_ != AdjacencyLayout::Packed) return;
+    packedTargets_   = PackedAdjacency(offsets_, targets_);
+    packedSources_   = PackedAdjacency(incomingOffsets_, sources_);
+    offsets_         = std::vector<std::uint32_t>();
+    targets_         = std::vector<Vertex>();
+    incomingOffsets_ = std::vector<std::uint32_t>();
+    sources_         = std::vector<Vertex>();
+}
\ No newline at end of file
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "PackedAdjacency.h"
+#include "Point.h"
+#include "algorithms.h"
+#include "metrics.h"
+
+namespace citymap
+{
+
+    class Map;
+
+    // how the vertices of a CompactGraph are numbered, picked by --order
+    enum class VertexOrder : unsigned char {
+        Input,    // ascending PointId, the ids of the coordinates file whatever their line order
+        Hilbert,  // along a Hilbert curve over the point coordinates
+        Bfs,      // breadth first over the undirected road network
+        Rcm,      // reverse Cuthill-McKee, bfs visiting low degree neighbours first
+    };
+
+    // how the arcs followed by the searches of a CompactGraph are stored
+    enum class AdjacencyLayout : unsigned char {
+        Plain,   // arrays of 32-bit vertices
+        Packed,  // gap encoded varints, see PackedAdjacency
+    };
+
+    /**
+     * Immutable CSR snapshot of a Map.
+     *
+     * Points are renumbered to dense vertices 0..n-1 in the chosen order, so searches run over
+     * flat arrays and geographically close points can be placed close in memory.
+     * PointIds are only translated at the boundary (vertexOf / idOf).
+     * Arcs are visited with forEachNeighbour / forEachIncoming, which decode them on the fly in the
+     * packed adjacency layout. That layout keeps no plain lists at all. Searches run on the engines
+     * of lib/graphs (graphs::search), arcs() and incomingArcs() weigh the arcs by a metric.
+     */
+    class CompactGraph {
+    public:
+        using Vertex      = std::uint32_t;
+        using vertex_type = Vertex;  // graphs::graph, vertices 0..n-1
+
+        static constexpr Vertex nvtx         = static_cast<Vertex>(-1);
+        static constexpr bool dense_vertices = true;
+
+        class ArcRange;
+
+        CompactGraph() = default;
+        explicit CompactGraph(const Map&, VertexOrder = VertexOrder::Input,
+                              AdjacencyLayout = AdjacencyLayout::Plain);
+        CompactGraph(const CompactGraph&, const Map&, std::span<const PointId>);
+
+        std::size_t size() const noexcept;
+        std::size_t edgeCount() const noexcept;
+        template<typename F>
+        void forEachNeighbour(Vertex, F) const;
+        template<typename F>
+        void forEachIncoming(Vertex, F) const;
+        ArcRange adjacent(Vertex) const noexcept;
+        std::ranges::iota_view<Vertex, Vertex> vertices() const noexcept;
+        const Point& point(Vertex) const noexcept;
+        Vertex vertexOf(PointId) const noexcept;
+        PointId idOf(Vertex) const noexcept;
+        VertexOrder order() const noexcept;
+        AdjacencyLayout adjacency() const noexcept;
+        std::size_t adjacencyBytes() const noexcept;
+        std::uint64_t generation() const noexcept;
+        double edgeSpan() const noexcept;
+        std::uint64_t fingerprint() const noexcept;
+
+        auto weight(metrics::Metric) const;
+        auto arcs(metrics::Metric) const;
+        auto incomingArcs(metrics::Metric) const;
+        auto dualArcs(metrics::Metric, metrics::Metric) const;
+
+    private:
+        using Permutation = std::vector<Vertex>;
+
+        std::span<const Vertex> targetsOf(Vertex) const noexcept;
+        std::span<const Vertex> sourcesOf(Vertex) const noexcept;
+        template<bool reverse, typename F>
+        void forEachArc(Vertex, F) const;
+
+        Permutation hilbertOrder() const;
+        Permutation bfsOrder(bool) const;
+        void permute(const Permutation&);
+        void reverseArcs();
+        void pack();
+
+        std::size_t edges_ {};
+        std::vector<std::uint32_t> offsets_ {0};  // plain layout
+        std::vector<Vertex> targets_;
+        std::vector<std::uint32_t> incomingOffsets_ {0};
+        std::vector<Vertex> sources_;
+        PackedAdjacency packedTargets_;  // packed layout
+        PackedAdjacency packedSources_;
+        std::vector<Point> points_;
+        std::vector<PointId> ids_;
+        std::shared_ptr<const std::unordered_map<PointId, Vertex>> vertices_;  // shared by patches
+        VertexOrder order_ {};
+        AdjacencyLayout adjacency_ {};
+        std::uint64_t generation_ {};
+    };
+
+    /**
+     * The arcs leaving a vertex in either layout, as a forward range for algorithms that keep
+     * iterators into adjacency lists (graphs::graph). Searches use forEachNeighbour instead, it
+     * branches on the layout once per vertex rather than once per arc.
+     */
+    class CompactGraph::ArcRange : public std::ranges::view_interface<ArcRange> {
+    public:
+        class iterator {
+        public:
+            using value_type       = Vertex;
+            using difference_type  = std::ptrdiff_t;
+            using iterator_concept = std::forward_iterator_tag;
+
+            iterator() = default;
+
+            Vertex operator*() const noexcept { return vertex_; }
+            iterator& operator++() noexcept;
+            iterator operator++(int) noexcept;
+            bool operator==(const iterator&) const noexcept = default;
+            bool operator==(std::default_sentinel_t) const noexcept { return done_; }
+
+        private:
+            friend class ArcRange;
+
+            const Vertex* plain_ {};  // current plain entry, null in the packed layout
+            const Vertex* plainEnd_ {};
+            const std::uint8_t* packed_ {};  // next packed entry
+            const std::uint8_t* packedEnd_ {};
+            Vertex vertex_ {};
+            bool done_ {true};
+        };
+
+        ArcRange() = default;
+
+        iterator begin() const noexcept;
+        std::default_sentinel_t end() const noexcept { return {}; }
+
+    private:
+        friend class CompactGraph;
+
+        ArcRange(Vertex source, std::span<const Vertex> plain,
+                 std::span<const std::uint8_t> packed, bool isPacked) noexcept
+            : source_(source), plain_(plain), packed_(packed), isPacked_(isPacked) {}
+
+        Vertex source_ {};
+        std::span<const Vertex> plain_;
+        std::span<const std::uint8_t> packed_;
+        bool isPacked_ {};
+    };
+
+    inline CompactGraph::ArcRange::iterator CompactGraph::ArcRange::begin() const noexcept {
+        iterator it;
+        if (isPacked_) {
+            it.packed_    = packed_.data();
+            it.packedEnd_ = packed_.data() + packed_.size();
+            it.done_      = packed_.empty();
+            if (!it.done_) it.vertex_ = PackedAdjacency::first(source_, it.packed_);
+        }
+        else {
+            it.plain_    = plain_.data();
+            it.plainEnd_ = plain_.data() + plain_.size();
+            it.done_     = plain_.empty();
+            if (!it.done_) it.vertex_ = *it.plain_;
+        }
+        return it;
+    }
+
+    inline CompactGraph::ArcRange::iterator&
+    CompactGraph::ArcRange::iterator::operator++() noexcept {
+        if (plain_) {
+            if (++plain_ == plainEnd_)
+                done_ = true;
+            else
+                vertex_ = *plain_;
+        }
+        else if (packed_ == packedEnd_)
+            done_ = true;
+        else
+            vertex_ = PackedAdjacency::next(vertex_, packed_);
+        return *this;
+    }
+
+    inline CompactGraph::ArcRange::iterator
+    CompactGraph::ArcRange::iterator::operator++(int) noexcept {
+        auto previous = *this;
+        ++*this;
+        return previous;
+    }
+
+    // f(v) for every arc u -> v, v -> u when reverse, in whichever layout the arcs are stored
+    template<bool reverse, typename F>
+    void CompactGraph::forEachArc(Vertex u, F f) const {
+        if (adjacency_ == AdjacencyLayout::Packed)
+            (reverse ? packedSources_ : packedTargets_).forEach(u, f);
+        else
+            for (auto v : reverse ? sourcesOf(u) : targetsOf(u))
+                f(v);
+    }
+
+    // f(v) for every arc u -> v
+    template<typename F>
+    void CompactGraph::forEachNeighbour(Vertex u, F f) const {
+        forEachArc<false>(u, f);
+    }
+
+    // f(v) for every arc v -> u
+    template<typename F>
+    void CompactGraph::forEachIncoming(Vertex u, F f) const {
+        forEachArc<true>(u, f);
+    }
+
+    // weight(u, v) of graphs::dijkstra and graphs::astar, the length of the arc u -> v
+    inline auto CompactGraph::weight(metrics::Metric metric) const {
+        return [this, metric](Vertex u, Vertex v) { return metric(points_[u], points_[v]); };
+    }
+
+    // arcs(u, relax) of graphs::search, relax(v, length) for every arc u -> v
+    inline auto CompactGraph::arcs(metrics::Metric metric) const {
+        return [this, metric](Vertex u, auto&& relax) {
+            forEachArc<false>(u, [&](Vertex v) { relax(v, metric(points_[u], points_[v])); });
+        };
+    }
+
+    // arcs(u, relax) running against the edges, relax(v, length) for every arc v -> u
+    inline auto CompactGraph::incomingArcs(metrics::Metric metric) const {
+        return [this, metric](Vertex u, auto&& relax) {
+            forEachArc<true>(u, [&](Vertex v) { relax(v, metric(points_[v], points_[u])); });
+        };
+    }
+
+    // arcs(u, visit) of graphs::dualDijkstra, visit(v, lengths) for every arc u -> v. lengths()
+    // fetches the coordinates of v and weighs the arc by both metrics.
+    inline auto CompactGraph::dualArcs(metrics::Metric first, metrics::Metric second) const {
+        return [this, first, second](Vertex u, auto&& visit) {
+            auto& from = points_[u];
+            forEachArc<false>(u, [&](Vertex v) {
+                visit(v, [&] {
+                    auto& to = points_[v];
+                    return std::pair(first(from, to), second(from, to));
+                });
+            });
+        };
+    }
+
+}  // namespace citymap
+
+// ArcRange only points into the graph, iterators outlive it
+template<>
+inline constexpr bool std::ranges::enable_borrowed_range<citymap::CompactGraph::ArcRange> = true;
+
+namespace citymap
+{
+
+    // labels of the searches over a snapshot, one kept per thread reuses its memory
+    using SearchTree     = graphs::SearchTree<CompactGraph, double>;
+    using DualSearchTree = graphs::DualSearchTree<CompactGraph, double>;
+
+}  // namespace citymap
\ No newline at end of file
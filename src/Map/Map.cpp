@@ -1,14 +1,47 @@
 #include "Map.h"
 
 #include <algorithm>
-#include <queue>
+#include <future>
+#include <limits>
+#include <stdexcept>
+
+#include "DeltaStepping.h"
+#include "HopMatrix.h"
+#include "HubLabels.h"
+#include "KShortestPaths.h"
+#include "Landmarks.h"
+#include "Overlay.h"
+#include "ShortestPathTrees.h"
+#include "ThreadPool.h"
+#include "algorithms.h"
 
 using namespace citymap;
 
+metrics::Metric Map::metricOf(PathType type) noexcept {
+    if (type == PathType::Car) return metrics::manhattan;
+    return metrics::euclidean;
+}
+
+// Points, their names and connections are allocated from the resource, e.g. an arena the whole
+// map is built in. It must outlive the map and be thread safe for a parallel load.
+Map::Map(std::pmr::memory_resource* resource)
+    : points_(resource), nameIndex_(resource) {}
+
+// Category a point is tagged with when it is added: its name without a numeric suffix,
+// so Szpital, Szpital2 and Szpital_3 are all facilities of category Szpital.
+std::string_view Map::defaultCategory(std::string_view name) noexcept {
+    auto stem = name.substr(0, name.find_last_not_of("0123456789") + 1);
+    if (stem.empty() || stem.size() == name.size()) return name;
+    auto end = stem.find_last_not_of("_-#");
+    return end == std::string_view::npos ? name : stem.substr(0, end + 1);
+}
+
 PointId Map::addPoint(std::string_view name, Point val) {
     auto id = nextId_++;
     if (auto [it, success] = points_.try_emplace(id, name, val); success) {
         nameIndex_.emplace(it->second.name, id);
+        category(id, defaultCategory(it->second.name));
+        bumpGeneration();
         return id;
     }
     else
@@ -19,6 +52,8 @@ PointId Map::addPoint(PointId id, std::string_view name, Point val) {
     if (id > nextId_) nextId_ = id + 1;
     if (auto [it, success] = points_.try_emplace(id, name, val); success) {
         nameIndex_.emplace(it->second.name, id);
+        category(id, defaultCategory(it->second.name));
+        bumpGeneration();
         return id;
     }
     else
@@ -28,16 +63,20 @@ PointId Map::addPoint(PointId id, std::string_view name, Point val) {
 void Map::removePoint(std::string_view name) {
     if (!contains(name)) return;
     PointId id = idOf(name);
+    untag(id, points_[id].category);
     nameIndex_.erase(name);
     points_.erase(id);
     std::ranges::for_each(points_, [&id](auto& ref) { ref.second.connections.erase(id); });
+    bumpGeneration();
 }
 
 void Map::removePoint(PointId id) {
     if (!contains(id)) return;
+    untag(id, points_[id].category);
     nameIndex_.erase(points_[id].name);
     points_.erase(id);
     std::ranges::for_each(points_, [&id](auto& ref) { ref.second.connections.erase(id); });
+    bumpGeneration();
 }
 
 void Map::addConnection(std::string_view a, std::string_view b) {
@@ -45,7 +84,16 @@ void Map::addConnection(std::string_view a, std::string_view b) {
 }
 
 void Map::addConnection(PointId a, PointId b) {
-    if (a != b) points_.at(a).connections.insert(b);
+    if (a != b && points_.at(a).connections.insert(b).second) bumpGeneration();
+}
+
+// all connections of a, with a single generation bump for the batch
+void Map::addConnections(PointId a, std::span<const PointId> targets) {
+    auto& connections = points_.at(a).connections;
+    bool added        = false;
+    for (auto b : targets)
+        if (a != b && connections.insert(b).second) added = true;
+    if (added) bumpGeneration();
 }
 
 void Map::removeConnection(std::string_view a, std::string_view b) {
@@ -53,7 +101,70 @@ void Map::removeConnection(std::string_view a, std::string_view b) {
 }
 
 void Map::removeConnection(PointId a, PointId b) {
-    points_.at(a).connections.erase(b);
+    if (points_.at(a).connections.erase(b)) bumpGeneration();
+}
+
+// Copy-on-write batch of connection changes for a map being queried concurrently. The current
+// snapshot is patched in its own numbering, the overlay, landmarks and pinned shortest path trees
+// are repaired for the patch and all of them are published in atomic swaps, readers never wait
+// for them. Hub labels cannot
+// be repaired and are dropped, distances are searched again. Points and names are left alone,
+// so only the snapshots and connection lookups can change under a query.
+void Map::update(std::span<const ConnectionChange> changes) {
+    for (auto& change : changes)
+        if (!contains(change.from) || !contains(change.to))
+            throw std::out_of_range("Map: unknown point");
+    {
+        std::scoped_lock lock(compactMutex_);
+        auto previous = compact_.load();
+        bool patch    = previous && previous->generation() == generation()
+                    && previous->order() == layout() && previous->adjacency() == adjacency();
+
+        std::vector<PointId> sources;
+        for (auto [from, to, connect] : changes) {
+            auto& connections = points_.at(from).connections;
+            if (connect ? from != to && connections.insert(to).second : connections.erase(to) > 0)
+                sources.push_back(from);
+        }
+        if (sources.empty()) return;
+        bumpGeneration();
+        if (patch)
+            publish(*previous, std::make_shared<const CompactGraph>(*previous, *this, sources),
+                    changes);
+        else
+            compact_.store(std::make_shared<const CompactGraph>(*this, layout(), adjacency()));
+    }
+    rcu::synchronize();  // the previous versions are freed once their last readers are done
+}
+
+// Publishes a patch of the previous snapshot with the overlay, landmarks and trees repaired for it.
+// Readers pairing the new snapshot with an index of the old one see it does not fit and search
+// without it until the index is swapped as well.
+void Map::publish(const CompactGraph& previous, std::shared_ptr<const CompactGraph> graph,
+                  std::span<const ConnectionChange> changes) {
+    using Arc = std::pair<CompactGraph::Vertex, CompactGraph::Vertex>;
+    std::vector<Arc> arcs, inserted, removed;
+    for (auto [from, to, connect] : changes) {
+        Arc arc {graph->vertexOf(from), graph->vertexOf(to)};
+        arcs.push_back(arc);
+        if (connect && hasConnection(from, to)) inserted.push_back(arc);
+        if (!connect && !hasConnection(from, to)) removed.push_back(arc);
+    }
+    std::shared_ptr<const Overlay> ovl;
+    if (auto old = overlay_.load(); old && old->fits(previous))
+        ovl = std::make_shared<const Overlay>(*old, *graph, arcs);
+    std::shared_ptr<const Landmarks> alt;
+    if (auto old = landmarks_.load(); old && old->fits(previous))
+        alt = std::make_shared<const Landmarks>(*old, *graph, inserted);
+    std::shared_ptr<const ShortestPathTrees> spt;
+    if (auto old = shortestPathTrees_.load(); old && old->fits(previous))
+        spt = std::make_shared<const ShortestPathTrees>(*old, *graph, inserted, removed);
+
+    compact_.store(std::move(graph));
+    if (ovl) overlay_.store(std::move(ovl));
+    if (alt) landmarks_.store(std::move(alt));
+    if (spt) shortestPathTrees_.store(std::move(spt));
+    hubLabels_.store(nullptr);
 }
 
 bool Map::hasConnection(std::string_view a, std::string_view b) const {
@@ -64,7 +175,11 @@ bool Map::hasConnection(PointId a, PointId b) const {
     return points_.at(a).connections.contains(b);
 }
 
-const std::string& Map::nameOf(PointId id) const {
+const Map::ConnectionSet& Map::connectionsOf(PointId id) const {
+    return points_.at(id).connections;
+}
+
+std::string_view Map::nameOf(PointId id) const {
     return points_.at(id).name;
 }
 
@@ -72,16 +187,53 @@ PointId Map::idOf(std::string_view name) const {
     return nameIndex_.at(name);
 }
 
-Point& Map::valueOf(std::string_view name) {
-    return valueOf(idOf(name));
+// single lookup alternative to contains() + idOf(), npnt when the name is unknown
+PointId Map::find(std::string_view name) const noexcept {
+    auto it = nameIndex_.find(name);
+    return it == nameIndex_.end() ? npnt : it->second;
+}
+
+// tags a point with a facility category, replacing its previous one
+void Map::category(PointId id, std::string_view name) {
+    auto& data          = points_.at(id);
+    auto next           = static_cast<CategoryId>(categoryNames_.size());
+    auto [it, inserted] = categoryIndex_.try_emplace(std::string(name), next);
+    if (inserted) {
+        categoryNames_.emplace_back(name);
+        facilities_.emplace_back();
+    }
+    if (data.category == it->second) return;
+    untag(id, data.category);
+    data.category = it->second;
+    facilities_[data.category].push_back(id);
+}
+
+CategoryId Map::categoryOf(PointId id) const {
+    return points_.at(id).category;
+}
+
+// ncat when no point has this category
+CategoryId Map::findCategory(std::string_view name) const noexcept {
+    auto it = categoryIndex_.find(std::string(name));
+    return it == categoryIndex_.end() ? ncat : it->second;
+}
+
+const std::string& Map::categoryName(CategoryId category) const {
+    return categoryNames_.at(category);
+}
+
+const std::vector<PointId>& Map::facilities(CategoryId category) const {
+    return facilities_.at(category);
 }
 
 const Point& Map::valueOf(std::string_view name) const {
     return valueOf(idOf(name));
 }
 
-Point& Map::valueOf(PointId id) {
-    return points_.at(id).val;
+// moves a point, the generation is bumped once the new coordinates are in place
+void Map::value(PointId id, Point val) {
+    points_.at(id).val = val;
+    bumpGeneration();
 }
 
 const Point& Map::valueOf(PointId id) const {
@@ -96,6 +248,14 @@ bool Map::contains(std::string_view name) const noexcept {
     return nameIndex_.contains(name);
 }
 
+std::vector<PointId> Map::ids() const {
+    std::vector<PointId> ids;
+    ids.reserve(points_.size());
+    for (auto& [id, data] : points_)
+        ids.push_back(id);
+    return ids;
+}
+
 std::size_t Map::size() const {
     return points_.size();
 }
@@ -107,35 +267,309 @@ bool Map::empty() const noexcept {
 void Map::clear() noexcept {
     points_.clear();
     nameIndex_.clear();
+    categoryNames_.clear();
+    categoryIndex_.clear();
+    facilities_.clear();
     nextId_ = 0;
+    bumpGeneration();
 }
 
-std::unique_ptr<Path> Map::findPath(const Query& query) const {
-    if (query.type() == PathType::Pedestrian)
-        return std::make_unique<PedestrianPath>(
-            findPedestrianPath(static_cast<const PedestrianQuery&>(query)));
-    else
-        return std::make_unique<CarPath>(findCarPath(static_cast<const CarQuery&>(query)));
+std::uint64_t Map::generation() const noexcept {
+    return generation_.load(std::memory_order_acquire);
+}
+
+// numbering of the compact snapshot used for searches, results do not depend on it
+void Map::layout(VertexOrder order) noexcept {
+    order_.store(order, std::memory_order_release);
+}
+
+VertexOrder Map::layout() const noexcept {
+    return order_.load(std::memory_order_acquire);
+}
+
+// storage of the arcs of the compact snapshot, results do not depend on it either
+void Map::adjacency(AdjacencyLayout adjacency) noexcept {
+    adjacency_.store(adjacency, std::memory_order_release);
+}
+
+AdjacencyLayout Map::adjacency() const noexcept {
+    return adjacency_.load(std::memory_order_acquire);
+}
+
+// Lock free while the published snapshot is current, rebuilt lazily once the map has changed.
+// Callers share the snapshot, so searches still running on an older one are unaffected by a
+// rebuild. While update() builds the next version readers carry on with the previous one.
+std::shared_ptr<const CompactGraph> Map::compact() const {
+    auto current = [this](const std::shared_ptr<const CompactGraph>& graph) {
+        return graph && graph->generation() == generation() && graph->order() == layout() &&
+               graph->adjacency() == adjacency();
+    };
+    auto graph = compact_.load();
+    if (current(graph)) return graph;
+
+    std::unique_lock lock(compactMutex_, std::defer_lock);
+    if (!graph)
+        lock.lock();
+    else if (!lock.try_lock())
+        return graph;
+    graph = compact_.load();
+    if (!current(graph)) {
+        graph = std::make_shared<const CompactGraph>(*this, layout(), adjacency());
+        compact_.store(graph);
+    }
+    return graph;
+}
+
+// ALT tables used by searches for as long as they fit the current snapshot
+void Map::landmarks(std::shared_ptr<const Landmarks> landmarks) {
+    landmarks_.store(std::move(landmarks));
+}
+
+std::shared_ptr<const Landmarks> Map::landmarks() const {
+    return landmarks_.load();
+}
+
+// customized overlay used by searches for as long as it fits the current snapshot
+void Map::overlay(std::shared_ptr<const Overlay> overlay) {
+    overlay_.store(std::move(overlay));
+}
+
+std::shared_ptr<const Overlay> Map::overlay() const {
+    return overlay_.load();
+}
+
+// hub labels answering findDistance for as long as they fit the current snapshot
+void Map::hubLabels(std::shared_ptr<const HubLabels> labels) {
+    hubLabels_.store(std::move(labels));
+}
+
+std::shared_ptr<const HubLabels> Map::hubLabels() const {
+    return hubLabels_.load();
+}
+
+// trees of pinned sources answering their searches for as long as they fit the current snapshot
+void Map::shortestPathTrees(std::shared_ptr<const ShortestPathTrees> trees) {
+    shortestPathTrees_.store(std::move(trees));
+}
+
+std::shared_ptr<const ShortestPathTrees> Map::shortestPathTrees() const {
+    return shortestPathTrees_.load();
+}
+
+static PathPtr emptyPath(PathType type, std::pmr::memory_resource* resource) {
+    if (type == PathType::Pedestrian) return makePath<PedestrianPath>(resource);
+    return makePath<CarPath>(resource);
+}
+
+// Legs of multi-stop queries are searched in parallel when a pool is given. The path is allocated
+// from the resource, e.g. the arena of a batch of queries.
+PathPtr Map::findPath(const Query& query, ThreadPool* pool,
+                      std::pmr::memory_resource* resource) const {
+    auto path = emptyPath(query.type(), resource);
+    findPath(query, query.type(), *path, pool);
+    return path;
+}
+
+// The route of the query under its own type followed by the other one. A point to point query
+// with no pinned tree, overlay or landmarks to use is answered by one fused dual-metric search,
+// which walks the arcs and fetches the coordinates of a point once for both.
+PolymorphicPathList Map::findBothPaths(const Query& query, ThreadPool* pool,
+                                       std::pmr::memory_resource* resource) const {
+    thread_local DualSearchTree trees;
+    auto other = query.type() == PathType::Car ? PathType::Pedestrian : PathType::Car;
+    PolymorphicPathList paths(resource);
+    paths.push_back(emptyPath(query.type(), resource));
+    paths.push_back(emptyPath(other, resource));
+
+    auto graph  = compact();
+    auto source = graph->vertexOf(query.from()), target = graph->vertexOf(query.to());
+    auto spt    = shortestPathTrees();
+    auto ovl    = overlay();
+    auto alt    = landmarks();
+    if (query.nearest() != ncat || !query.via().empty() || source == CompactGraph::nvtx
+        || (spt && spt->fits(*graph) && spt->pinned(source)) || (ovl && ovl->fits(*graph))
+        || (alt && alt->fits(*graph)))
+    {
+        findPath(query, query.type(), *paths[0], pool);
+        findPath(query, other, *paths[1], pool);
+        return paths;
+    }
+    if (target == CompactGraph::nvtx) throw std::out_of_range("Map: unknown point");
+
+    graphs::dualDijkstra(*graph, source, target,
+                         graph->dualArcs(metricOf(query.type()), metricOf(other)), trees);
+    for (std::size_t i = 0; i < 2; i++) {
+        paths[i]->endpoints(query.from(), query.to());
+        paths[i]->distance_ = trees[i].distance(target);
+        for (auto v : trees[i].path(target))
+            paths[i]->points_.push_back(graph->idOf(v));
+    }
+    return paths;
 }
 
 CarPath Map::findCarPath(CarQuery query) const {
     CarPath path;
-    findPath(query.from(), query.to(), dijkstra(query.from(), metrics::manhattan), path);
+    findPath(query, PathType::Car, path, nullptr);
     return path;
 }
 
 PedestrianPath Map::findPedestrianPath(PedestrianQuery query) const {
     PedestrianPath path;
-    findPath(query.from(), query.to(), dijkstra(query.from(), metrics::euclidean), path);
+    findPath(query, PathType::Pedestrian, path, nullptr);
     return path;
 }
 
-std::string Map::describe(const Path::PointList& pl, const char* sep = ", ") const {
+// Length of the route of a point to point or multi-stop query, infinity when unreachable.
+// Legs are looked up in the hub labels when they fit the snapshot, searched otherwise.
+double Map::findDistance(const Query& query) const {
+    thread_local std::vector<CompactGraph::Vertex> route;
+    if (query.nearest() != ncat)
+        throw std::invalid_argument("Map: distances go between points, not to nearest:");
+
+    auto graph  = compact();
+    auto labels = hubLabels();
+    if (labels && !labels->fits(*graph)) labels = nullptr;
+    auto stops    = query.stops();
+    double length = 0.0;
+    for (std::size_t i = 0; i + 1 < stops.size(); i++) {
+        auto source = graph->vertexOf(stops[i]), target = graph->vertexOf(stops[i + 1]);
+        if (source == CompactGraph::nvtx || target == CompactGraph::nvtx)
+            throw std::out_of_range("Map: unknown point");
+        length += labels ? labels->distance(source, target, query.type())
+                         : search(*graph, source, target, query.type(), route);
+    }
+    return length;
+}
+
+// Budget bounded search on the compact snapshot, every reached point with its distance.
+// Arcs leading beyond the budget are not relaxed, so the search never leaves the isochrone.
+// Given a pool of several workers, which must not be called from one of its own tasks, large
+// isochrones are searched with delta-stepping. The points come in the same order either way.
+Isochrone Map::isochrone(PointId centre, double budget, PathType type, ThreadPool* pool) const {
+    using Vertex = CompactGraph::Vertex;
+    thread_local SearchTree tree;
+    auto graph  = compact();
+    auto source = graph->vertexOf(centre);
+    if (source == CompactGraph::nvtx) throw std::out_of_range("Map: unknown point");
+
+    Isochrone isochrone(centre, budget, type);
+    if (!(budget >= 0.0)) return isochrone;
+    // no route is shorter than the metric distance, the points within it bound the isochrone
+    auto large = [&] {
+        std::size_t within {};
+        for (Vertex v = 0; v < graph->size(); v++)
+            within += metricOf(type)(graph->point(source), graph->point(v)) <= budget;
+        return within >= DeltaStepping::minVertices;
+    };
+    if (DeltaStepping::pays(*graph, pool) && large()) {
+        DeltaStepping engine(*pool);
+        engine.run(*graph, source, metricOf(type), budget);
+        std::vector<std::pair<double, Vertex>> reached;  // settling order of the search below
+        for (Vertex v = 0; v < graph->size(); v++)
+            if (engine.distance(v) <= budget) reached.push_back({engine.distance(v), v});
+        std::ranges::sort(reached);
+        for (auto [distance, v] : reached)
+            isochrone.points_.push_back({graph->idOf(v), distance});
+        return isochrone;
+    }
+    auto arcs = [&, all = graph->arcs(metricOf(type))](Vertex u, auto&& relax) {
+        double base = tree.distance(u);
+        all(u, [&](Vertex v, double length) {
+            if (base + length <= budget) relax(v, length);
+        });
+    };
+    auto settled = [&](Vertex v) {  // in ascending distance
+        isochrone.points_.push_back({graph->idOf(v), tree.distance(v)});
+        return false;
+    };
+    graphs::search(*graph, std::views::single(source), arcs, graphs::noPotential, settled, tree);
+    return isochrone;
+}
+
+// Up to k loopless routes of a point to point query in ascending distance, the first is the
+// shortest. Other query forms have just the one route.
+PolymorphicPathList Map::findAlternatives(const Query& query, std::size_t k,
+                                          std::pmr::memory_resource* resource) const {
+    thread_local KShortestPaths engine;
+    PolymorphicPathList paths(resource);
+    if (k <= 1 || query.nearest() != ncat || !query.via().empty()) {
+        paths.push_back(findPath(query, nullptr, resource));
+        return paths;
+    }
+
+    auto graph  = compact();
+    auto source = graph->vertexOf(query.from()), target = graph->vertexOf(query.to());
+    if (source == CompactGraph::nvtx || target == CompactGraph::nvtx)
+        throw std::out_of_range("Map: unknown point");
+
+    for (auto& route : engine.find(*graph, source, target, k, metricOf(query.type()))) {
+        auto& path      = paths.emplace_back(emptyPath(query.type(), resource));
+        path->distance_ = route.distance;
+        for (auto v : route.vertices)
+            path->points_.push_back(graph->idOf(v));
+    }
+    if (paths.empty()) paths.push_back(findPath(query, nullptr, resource));  // unreachable
+    return paths;
+}
+
+// Routes with the fewest hops for point pairs, all answered over one bit matrix of the snapshot
+// in multi-source sweeps of up to 64 sources. Unreachable pairs get an empty route.
+std::vector<Path::PointList>
+Map::findFewestHops(std::span<const std::pair<PointId, PointId>> pairs) const {
+    auto graph = compact();
+    std::vector<std::pair<CompactGraph::Vertex, CompactGraph::Vertex>> legs;
+    legs.reserve(pairs.size());
+    for (auto [from, to] : pairs) {
+        auto source = graph->vertexOf(from), target = graph->vertexOf(to);
+        if (source == CompactGraph::nvtx || target == CompactGraph::nvtx)
+            throw std::out_of_range("Map: unknown point");
+        legs.emplace_back(source, target);
+    }
+
+    HopMatrix matrix(*graph);
+    std::vector<Path::PointList> routes;
+    routes.reserve(pairs.size());
+    for (auto& route : matrix.routes(legs)) {
+        auto& points = routes.emplace_back();
+        for (auto v : route)
+            points.push_back(graph->idOf(v));
+    }
+    return routes;
+}
+
+// Every point routed to its closest facility of the category, all from one search over the
+// incoming connections seeded with every facility. Points reaching none are left out.
+PolymorphicPathList Map::findNearest(CategoryId category, PathType type,
+                                     std::pmr::memory_resource* resource) const {
+    thread_local SearchTree tree;
+    auto graph = compact();
+    std::vector<CompactGraph::Vertex> targets;
+    for (auto id : facilities(category))
+        if (auto v = graph->vertexOf(id); v != CompactGraph::nvtx) targets.push_back(v);
+    graphs::search(*graph, targets, graph->incomingArcs(metricOf(type)), graphs::noPotential,
+                   graphs::noGoal, tree);
+
+    PolymorphicPathList paths(resource);
+    for (CompactGraph::Vertex v = 0; v < graph->size(); v++) {
+        if (!tree.reached(v)) continue;
+        auto& path      = paths.emplace_back(emptyPath(type, resource));
+        path->distance_ = tree.distance(v);
+        path->points_.push_back(graph->idOf(v));
+        for (auto u = v; *tree.parent(u) != u; u = *tree.parent(u))
+            path->points_.push_back(graph->idOf(*tree.parent(u)));
+    }
+    std::ranges::sort(paths, {}, [](auto& path) { return path->from(); });
+    return paths;
+}
+
+std::string Map::describe(std::span<const PointId> pl, const char* sep = ", ") const {
     if (pl.empty()) return std::string();
 
     std::string output;
-    for (std::size_t i = 0; i < pl.size() - 1; i++)
-        output += points_.at(pl[i]).name + sep;
+    for (std::size_t i = 0; i < pl.size() - 1; i++) {
+        output += points_.at(pl[i]).name;
+        output += sep;
+    }
     output += points_.at(pl.back()).name;
     return output;
 }
@@ -148,47 +582,151 @@ bool Map::isValid(const Path& path) const noexcept {
     return true;
 }
 
-Map::DijkstraResult Map::dijkstra(PointId start, metrics::Metric metric) const {
-    DijkstraResult result;
-    for (auto& [key, val] : points_)
-        result[key];
-
-    auto compFunc = [&result](PointId a, PointId b) -> bool {
-        return result[a].distance < result[b].distance;
-    };
+void Map::bumpGeneration() noexcept {
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+}
 
-    std::priority_queue<PointId, std::vector<PointId>, decltype(compFunc)> queue(compFunc);
+void Map::untag(PointId id, CategoryId category) {
+    if (category != ncat) std::erase(facilities_[category], id);
+}
 
-    result[start] = {0, start};
-    queue.push(start);
+// dispatches on the form of the query
+void Map::findPath(const Query& query, PathType type, Path& path, ThreadPool* pool) const {
+    path.endpoints(query.from(), query.to());
+    if (query.nearest() != ncat)
+        findNearest(query.from(), query.nearest(), type, path);
+    else if (!query.via().empty())
+        findRoute(query.stops(), type, path, pool);
+    else
+        findPath(query.from(), query.to(), type, path);
+}
 
-    while (!queue.empty()) {
-        PointId currentPoint = queue.top();
-        queue.pop();
-        double currentDistance = result[currentPoint].distance;
+// Runs on the compact snapshot, vertices are translated back to PointIds for the path.
+void Map::findPath(PointId from, PointId to, PathType type, Path& path) const {
+    thread_local std::vector<CompactGraph::Vertex> route;
+    auto graph  = compact();
+    auto source = graph->vertexOf(from), target = graph->vertexOf(to);
+    if (source == CompactGraph::nvtx || target == CompactGraph::nvtx)
+        throw std::out_of_range("Map: unknown point");
+
+    path.distance_ = search(*graph, source, target, type, route);
+    for (auto v : route)
+        path.points_.push_back(graph->idOf(v));
+}
 
-        for (auto& neighbour : points_.at(currentPoint).connections) {
-            double newDistance
-                = currentDistance + metric(valueOf(currentPoint), valueOf(neighbour));
-            if (newDistance < result[neighbour].distance) {
-                result[neighbour] = {newDistance, currentPoint};
-                queue.push(neighbour);
-            }
-        }
+// Route through ordered stops, the legs concatenated. Legs leaving the same stop share one search
+// running until all their targets are settled, distinct stops are searched in parallel on the pool.
+// Unreachable when any leg is.
+void Map::findRoute(const std::vector<PointId>& stops, PathType type, Path& path,
+                    ThreadPool* pool) const {
+    using Vertex = CompactGraph::Vertex;
+    auto graph   = compact();
+    std::vector<Vertex> vertices;
+    for (auto id : stops)
+        if (vertices.push_back(graph->vertexOf(id)); vertices.back() == CompactGraph::nvtx)
+            throw std::out_of_range("Map: unknown point");
+
+    std::vector<std::vector<std::size_t>> groups;  // legs by source
+    std::unordered_map<Vertex, std::size_t> groupOf;
+    for (std::size_t leg = 0; leg + 1 < vertices.size(); leg++) {
+        auto [it, inserted] = groupOf.try_emplace(vertices[leg], groups.size());
+        if (inserted) groups.emplace_back();
+        groups[it->second].push_back(leg);
     }
 
-    return result;
-}
+    std::vector<double> distances(vertices.size() - 1);
+    std::vector<std::vector<Vertex>> routes(vertices.size() - 1);
+    auto solve = [&](const std::vector<std::size_t>& legs) {
+        thread_local SearchTree tree;
+        auto source = vertices[legs.front()];
+        if (legs.size() == 1) {
+            distances[legs.front()] = search(*graph, source, vertices[legs.front() + 1], type,
+                                             routes[legs.front()]);
+            return;
+        }
 
-void Map::findPath(PointId from, PointId to, const DijkstraResult& dj, Path& path) {
-    path.distance_ = dj.at(to).distance;
+        std::vector<Vertex> targets;
+        for (auto leg : legs)
+            targets.push_back(vertices[leg + 1]);
+        std::ranges::sort(targets);
+        auto [first, last] = std::ranges::unique(targets);
+        targets.erase(first, last);
+        auto pending = targets.size();
+        auto settled = [&](Vertex v) {
+            return std::ranges::binary_search(targets, v) && --pending == 0;
+        };
+        graphs::search(*graph, std::views::single(source), graph->arcs(metricOf(type)),
+                       graphs::noPotential, settled, tree);
+        for (auto leg : legs) {
+            distances[leg] = tree.distance(vertices[leg + 1]);
+            routes[leg]    = tree.path(vertices[leg + 1]);
+        }
+    };
 
-    PointId currentPoint = to;
-    while (currentPoint != from) {
-        path.points_.push_back(currentPoint);
-        currentPoint = dj.at(currentPoint).previous;
+    std::vector<std::future<void>> tasks;
+    for (std::size_t g = 1; g < groups.size(); g++) {
+        if (pool)
+            tasks.push_back(pool->submit([&solve, &legs = groups[g]] { solve(legs); }));
+        else
+            solve(groups[g]);
     }
-    path.points_.push_back(from);
+    solve(groups.front());
+    for (auto& task : tasks)
+        task.get();
+
+    path.distance_ = 0.0;
+    for (std::size_t leg = 0; leg < routes.size(); leg++) {
+        if (routes[leg].empty()) {
+            path.distance_ = std::numeric_limits<double>::infinity();
+            path.points_.clear();
+            return;
+        }
+        path.distance_ += distances[leg];
+        for (std::size_t i = leg ? 1 : 0; i < routes[leg].size(); i++)
+            path.points_.push_back(graph->idOf(routes[leg][i]));
+    }
+}
+
+// One point to point search, read off the tree of a pinned source or over the overlay or goal
+// directed when those fit the snapshot. The others run on the generic engines of lib/graphs with a
+// workspace kept per thread.
+double Map::search(const CompactGraph& graph, CompactGraph::Vertex source,
+                   CompactGraph::Vertex target, PathType type,
+                   std::vector<CompactGraph::Vertex>& route) const {
+    thread_local SearchTree tree;
+    if (auto spt = shortestPathTrees(); spt && spt->fits(graph) && spt->pinned(source))
+        return spt->route(source, target, type, route);
+    if (auto ovl = overlay(); ovl && ovl->fits(graph))
+        return ovl->search(graph, type, source, target, tree, route);
+
+    auto weight = graph.weight(metricOf(type));
+    if (auto alt = landmarks(); alt && alt->fits(graph))
+        graphs::astar(graph, source, target, weight,
+                      [&](CompactGraph::Vertex v) { return alt->lowerBound(v, target, type); },
+                      tree);
+    else
+        graphs::dijkstra(graph, source, weight, target, tree);
+    route = tree.path(target);
+    return tree.distance(target);
+}
 
-    std::ranges::reverse(path.points_);
+// Closest facility of the category, one search settling points until it meets one.
+void Map::findNearest(PointId from, CategoryId category, PathType type, Path& path) const {
+    thread_local SearchTree tree;
+    thread_local std::vector<CompactGraph::Vertex> goals;
+    auto graph  = compact();
+    auto source = graph->vertexOf(from);
+    if (source == CompactGraph::nvtx) throw std::out_of_range("Map: unknown point");
+
+    goals.clear();
+    for (auto id : facilities(category))
+        if (auto v = graph->vertexOf(id); v != CompactGraph::nvtx) goals.push_back(v);
+    std::ranges::sort(goals);
+
+    auto isGoal = [](CompactGraph::Vertex v) { return std::ranges::binary_search(goals, v); };
+    auto found  = graphs::search(*graph, std::views::single(source), graph->arcs(metricOf(type)),
+                                 graphs::noPotential, isGoal, tree);
+    path.distance_ = found ? tree.distance(*found) : std::numeric_limits<double>::infinity();
+    for (auto v : found ? tree.path(*found) : std::vector<CompactGraph::Vertex>())
+        path.points_.push_back(graph->idOf(v));
 }
\ No newline at end of file
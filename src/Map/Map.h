@@ -1,26 +1,53 @@
 #pragma once
 
+#include <atomic>
 #include <cstddef>
-#include <limits>
+#include <cstdint>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <span>
 #include <string>
 #include <string_view>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
+#include "CompactGraph.h"
+#include "Isochrone.h"
 #include "Path.h"
 #include "Point.h"
 #include "Query.h"
+#include "Rcu.h"
 #include "metrics.h"
 
 namespace citymap
 {
 
+    class HubLabels;
+    class Landmarks;
+    class Overlay;
+    class ShortestPathTrees;
+    class ThreadPool;
+
     class Map {
     public:
-        static constexpr PointId npnt = static_cast<PointId>(-1);
+        using ConnectionSet = std::pmr::unordered_set<PointId>;
+
+        struct ConnectionChange {
+            PointId from;
+            PointId to;
+            bool connect;  // added, or removed when false
+        };
 
-        Map()  = default;
+        static constexpr PointId npnt    = static_cast<PointId>(-1);
+        static constexpr CategoryId ncat = static_cast<CategoryId>(-1);
+
+        static metrics::Metric metricOf(PathType) noexcept;
+        static std::string_view defaultCategory(std::string_view) noexcept;
+
+        explicit Map(std::pmr::memory_resource* = std::pmr::get_default_resource());
         ~Map() = default;
 
         PointId addPoint(std::string_view, Point);
@@ -28,58 +55,113 @@ namespace citymap
         void removePoint(std::string_view);
         void removePoint(PointId);
         void addConnection(std::string_view, std::string_view);
-        void addConnection(PointId, PointId);
+        void addConnection(PointId, PointId);  // safe to call concurrently for distinct sources
+        void addConnections(PointId, std::span<const PointId>);  // likewise
         void removeConnection(std::string_view, std::string_view);
         void removeConnection(PointId, PointId);
+        void update(std::span<const ConnectionChange>);  // safe while other threads query
         bool hasConnection(std::string_view, std::string_view) const;
         bool hasConnection(PointId, PointId) const;
-        const std::string& nameOf(PointId) const;
+        const ConnectionSet& connectionsOf(PointId) const;
+        std::string_view nameOf(PointId) const;
         PointId idOf(std::string_view) const;
-        Point& valueOf(std::string_view);
+        PointId find(std::string_view) const noexcept;
+        void category(PointId, std::string_view);
+        CategoryId categoryOf(PointId) const;
+        CategoryId findCategory(std::string_view) const noexcept;
+        const std::string& categoryName(CategoryId) const;
+        const std::vector<PointId>& facilities(CategoryId) const;
+        void value(PointId, Point);
         const Point& valueOf(std::string_view) const;
-        Point& valueOf(PointId);
         const Point& valueOf(PointId) const;
         bool contains(PointId) const noexcept;
         bool contains(std::string_view) const noexcept;
+        std::vector<PointId> ids() const;
         std::size_t size() const;
         bool empty() const noexcept;
         void clear() noexcept;
-
-
-        std::unique_ptr<Path> findPath(const Query&) const;
+        std::uint64_t generation() const noexcept;
+        void layout(VertexOrder) noexcept;
+        VertexOrder layout() const noexcept;
+        void adjacency(AdjacencyLayout) noexcept;
+        AdjacencyLayout adjacency() const noexcept;
+        std::shared_ptr<const CompactGraph> compact() const;
+        void landmarks(std::shared_ptr<const Landmarks>);
+        std::shared_ptr<const Landmarks> landmarks() const;
+        void overlay(std::shared_ptr<const Overlay>);
+        std::shared_ptr<const Overlay> overlay() const;
+        void hubLabels(std::shared_ptr<const HubLabels>);
+        std::shared_ptr<const HubLabels> hubLabels() const;
+        void shortestPathTrees(std::shared_ptr<const ShortestPathTrees>);
+        std::shared_ptr<const ShortestPathTrees> shortestPathTrees() const;
+
+        PathPtr findPath(const Query&, ThreadPool* = nullptr,
+                         std::pmr::memory_resource* = std::pmr::get_default_resource()) const;
+        PolymorphicPathList findBothPaths(
+            const Query&, ThreadPool* = nullptr,
+            std::pmr::memory_resource* = std::pmr::get_default_resource()) const;
         CarPath findCarPath(CarQuery) const;
         PedestrianPath findPedestrianPath(PedestrianQuery) const;
-        std::string describe(const Path::PointList&, const char*) const;
+        double findDistance(const Query&) const;
+        Isochrone isochrone(PointId, double, PathType, ThreadPool* = nullptr) const;
+        PolymorphicPathList findNearest(
+            CategoryId, PathType,
+            std::pmr::memory_resource* = std::pmr::get_default_resource()) const;
+        PolymorphicPathList findAlternatives(
+            const Query&, std::size_t,
+            std::pmr::memory_resource* = std::pmr::get_default_resource()) const;
+        std::vector<Path::PointList> findFewestHops(std::span<const std::pair<PointId, PointId>>)
+            const;
+        std::string describe(std::span<const PointId>, const char*) const;
         bool isValid(const Path&) const noexcept;
 
     protected:
+        // allocator aware, points_ hands its resource down to the name and connections
         struct PointData {
-            PointData() = default;
+            using allocator_type = std::pmr::polymorphic_allocator<>;
+
+            explicit PointData(const allocator_type& allocator)
+                : name(allocator), connections(allocator) {}
 
-            PointData(std::string_view name, Point val)
-                : name(name), val(val) {}
+            PointData(std::string_view name, Point val, const allocator_type& allocator)
+                : name(name, allocator), val(val), connections(allocator) {}
 
             ~PointData() = default;
 
-            std::string name;
+            std::pmr::string name;
             Point val;
-            std::unordered_set<PointId> connections;
-        };
-
-        struct DijkstraData {
-            double distance  = std::numeric_limits<double>::infinity();
-            PointId previous = npnt;
+            ConnectionSet connections;
+            CategoryId category {ncat};
         };
 
-        using DijkstraResult = std::unordered_map<PointId, DijkstraData>;
-
-        DijkstraResult dijkstra(PointId, metrics::Metric) const;
-        static void findPath(PointId, PointId, const DijkstraResult&, Path&);
+        void findPath(const Query&, PathType, Path&, ThreadPool*) const;
+        void findPath(PointId, PointId, PathType, Path&) const;
+        void findRoute(const std::vector<PointId>&, PathType, Path&, ThreadPool*) const;
+        void findNearest(PointId, CategoryId, PathType, Path&) const;
+        double search(const CompactGraph&, CompactGraph::Vertex, CompactGraph::Vertex, PathType,
+                      std::vector<CompactGraph::Vertex>&) const;
 
     private:
+        void bumpGeneration() noexcept;
+        void publish(const CompactGraph&, std::shared_ptr<const CompactGraph>,
+                     std::span<const ConnectionChange>);
+        void untag(PointId, CategoryId);
+
         PointId nextId_ {};
-        std::unordered_map<PointId, PointData> points_;
-        std::unordered_map<std::string_view, PointId> nameIndex_;
+        std::atomic<std::uint64_t> generation_ {};  // changes with every mutation
+        std::pmr::unordered_map<PointId, PointData> points_;
+        std::pmr::unordered_map<std::string_view, PointId> nameIndex_;
+        std::vector<std::string> categoryNames_;
+        std::unordered_map<std::string, CategoryId> categoryIndex_;
+        std::vector<std::vector<PointId>> facilities_;  // per category
+        std::atomic<VertexOrder> order_ {};
+        std::atomic<AdjacencyLayout> adjacency_ {};
+        mutable std::mutex compactMutex_;  // serializes rebuilds and updates, readers go without
+        mutable rcu::Cell<CompactGraph> compact_;
+        rcu::Cell<Landmarks> landmarks_;
+        rcu::Cell<Overlay> overlay_;
+        rcu::Cell<HubLabels> hubLabels_;
+        rcu::Cell<ShortestPathTrees> shortestPathTrees_;
     };
 
 }  // namespace citymap
\ No newline at end of file
@@ -0,0 +1,44 @@
+#include "PackedAdjacency.h"
+
+#include <limits>
+#include <stdexcept>
+
+using namespace citymap;
+
+static void write(std::vector<std::uint8_t>& bytes, std::uint32_t value) {
+    while (value >= 0x80) {
+        bytes.push_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    bytes.push_back(static_cast<std::uint8_t>(value));
+}
+
+// offsets[u]..offsets[u + 1] delimit the list of u in targets
+PackedAdjacency::PackedAdjacency(std::span<const std::uint32_t> offsets,
+                                 std::span<const Vertex> targets) {
+    std::size_t lists = offsets.empty() ? 0 : offsets.size() - 1;
+    offsets_.reserve(lists + 1);
+    bytes_.reserve(targets.size() + targets.size() / 4);
+    for (Vertex u = 0; u < lists; u++) {
+        auto list = targets.subspan(offsets[u], offsets[u + 1] - offsets[u]);
+        if (!list.empty()) {
+            auto delta = static_cast<std::int32_t>(list.front() - u);  // modulo 2^32
+            write(bytes_, (static_cast<std::uint32_t>(delta) << 1) ^
+                              static_cast<std::uint32_t>(delta >> 31));
+        }
+        for (std::size_t i = 1; i < list.size(); i++) {
+            if (list[i] <= list[i - 1])
+                throw std::invalid_argument("PackedAdjacency: list not strictly ascending");
+            write(bytes_, list[i] - list[i - 1] - 1);
+        }
+        if (bytes_.size() > std::numeric_limits<std::uint32_t>::max())
+            throw std::length_error("PackedAdjacency: too many edges");
+        offsets_.push_back(static_cast<std::uint32_t>(bytes_.size()));
+    }
+    bytes_.shrink_to_fit();
+}
+
+// memory of the packed lists and their offsets
+std::size_t PackedAdjacency::bytes() const noexcept {
+    return bytes_.size() + offsets_.size() * sizeof(std::uint32_t);
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace citymap
+{
+
+    /**
+     * Compressed CSR adjacency lists.
+     *
+     * Every list must be sorted ascending without duplicates. Its first entry is stored as the
+     * zigzag encoded difference to the vertex itself, the others as the gap to their predecessor
+     * minus one, all as LEB128 varints. In a locality preserving vertex order most entries take a
+     * single byte instead of four.
+     */
+    class PackedAdjacency {
+    public:
+        using Vertex = std::uint32_t;
+
+        PackedAdjacency() = default;
+        PackedAdjacency(std::span<const std::uint32_t>, std::span<const Vertex>);
+
+        std::size_t bytes() const noexcept;
+        std::span<const std::uint8_t> list(Vertex) const noexcept;
+        template<typename F>
+        void forEach(Vertex, F) const;
+
+        static Vertex first(Vertex, const std::uint8_t*&) noexcept;
+        static Vertex next(Vertex, const std::uint8_t*&) noexcept;
+
+    private:
+        static std::uint32_t read(const std::uint8_t*&) noexcept;
+
+        std::vector<std::uint32_t> offsets_ {0};  // into bytes_
+        std::vector<std::uint8_t> bytes_;
+    };
+
+    // encoded list of u, decoded with first() and then next() until the span is used up
+    inline std::span<const std::uint8_t> PackedAdjacency::list(Vertex u) const noexcept {
+        return {bytes_.data() + offsets_[u], bytes_.data() + offsets_[u + 1]};
+    }
+
+    // calls f(v) for every v in the list of u, in ascending order
+    template<typename F>
+    void PackedAdjacency::forEach(Vertex u, F f) const {
+        const std::uint8_t* in  = bytes_.data() + offsets_[u];
+        const std::uint8_t* end = bytes_.data() + offsets_[u + 1];
+        if (in == end) return;
+        Vertex v = first(u, in);
+        f(v);
+        while (in != end) {
+            v = next(v, in);
+            f(v);
+        }
+    }
+
+    // the first entry of the list of u
+    inline PackedAdjacency::Vertex PackedAdjacency::first(Vertex u,
+                                                          const std::uint8_t*& in) noexcept {
+        std::uint32_t zigzag = read(in);
+        return u + ((zigzag >> 1) ^ (0u - (zigzag & 1)));
+    }
+
+    // the entry after v
+    inline PackedAdjacency::Vertex PackedAdjacency::next(Vertex v,
+                                                         const std::uint8_t*& in) noexcept {
+        return v + read(in) + 1;
+    }
+
+    inline std::uint32_t PackedAdjacency::read(const std::uint8_t*& in) noexcept {
+        std::uint32_t value = *in++;
+        if (value < 0x80) return value;
+        value &= 0x7f;
+        for (unsigned shift = 7;; shift += 7) {
+            std::uint32_t byte = *in++;
+            value |= (byte & 0x7f) << shift;
+            if (byte < 0x80) return value;
+        }
+    }
+
+}  // namespace citymap
\ No newline at end of file
@@ -1,10 +1,12 @@
 #pragma once
 #include "metrics.h"
 #include <cstddef>
+#include <cstdint>
 
 namespace citymap
 {
-    using PointId = std::size_t;
+    using PointId    = std::size_t;
+    using CategoryId = std::uint32_t;  // facility category of a point, see Map::category
 
     struct Point : public metrics::Point2 {
         Point() = default;
@@ -0,0 +1,362 @@
+#include "Overlay.h"
+
+#include <algorithm>
+#include <future>
+#include <limits>
+#include <numeric>
+
+#include "Map.h"
+
+using namespace citymap;
+
+static constexpr double infinity = std::numeric_limits<double>::infinity();
+
+// the entries of one cell in an array delimited by per cell offsets
+template<typename T, typename Offset>
+static std::span<const T> ofCell(const std::vector<T>& values, const std::vector<Offset>& offsets,
+                                 std::uint32_t cell) {
+    return std::span(values).subspan(offsets[cell], offsets[cell + 1] - offsets[cell]);
+}
+
+// Overlay::Weights
+
+metrics::Metric Overlay::Weights::metric() const noexcept {
+    return metric_;
+}
+
+bool Overlay::Weights::empty() const noexcept {
+    return metric_ == nullptr;
+}
+
+// Overlay
+
+Overlay::Overlay(const CompactGraph& graph, ThreadPool* pool, std::size_t cellSize,
+                 std::size_t levels)
+    : generation_(graph.generation()), order_(graph.order()), size_(graph.size()) {
+    // no level above the one whose cells already hold the whole map
+    for (std::size_t size = std::max<std::size_t>(cellSize, 1); cellSizes_.size() < levels;
+         size *= fanout)
+    {
+        cellSizes_.push_back(size);
+        if (size >= graph.size()) break;
+    }
+
+    levels_.resize(cellSizes_.size());
+    for (auto& level : levels_)
+        level.cellOf.assign(graph.size(), 0);
+    std::vector<Vertex> vertices(graph.size());
+    std::iota(vertices.begin(), vertices.end(), Vertex {});
+    partition(graph, vertices, levels_.size());
+    findBoundaries(graph);
+
+    for (auto type : {PathType::Pedestrian, PathType::Car})
+        profiles_[static_cast<std::size_t>(type)] = customize(graph, Map::metricOf(type), pool);
+}
+
+// Repairs previous for graph, a patch of its snapshot in which the given arcs were added or
+// removed. The partition only depends on the points and is kept, the boundaries are found again.
+// A cell is customized again when a changed arc shows on its level: inside a level 0 cell,
+// between two cells one level down or leaving the cell, which may change its boundary.
+Overlay::Overlay(const Overlay& previous, const CompactGraph& graph,
+                 std::span<const std::pair<Vertex, Vertex>> changed, ThreadPool* pool)
+    : cellSizes_(previous.cellSizes_), generation_(graph.generation()), order_(graph.order()),
+      size_(graph.size()) {
+    levels_.resize(previous.levels_.size());
+    std::vector<std::vector<bool>> redo(levels_.size());
+    for (std::size_t l = 0; l < levels_.size(); l++) {
+        auto& cellOf     = levels_[l].cellOf;
+        cellOf           = previous.levels_[l].cellOf;
+        levels_[l].cells = previous.levels_[l].cells;
+        redo[l].assign(levels_[l].cells, false);
+        for (auto [u, v] : changed)
+            if (l == 0 || levels_[l - 1].cellOf[u] != levels_[l - 1].cellOf[v])
+                redo[l][cellOf[u]] = redo[l][cellOf[v]] = true;
+    }
+    findBoundaries(graph);
+
+    for (std::size_t i = 0; i < profiles_.size(); i++) {
+        auto& weights = previous.profiles_[i];
+        Reuse reuse {previous, weights, redo};
+        profiles_[i] = customize(graph, weights.metric(), pool, &reuse);
+    }
+}
+
+std::size_t Overlay::levels() const noexcept {
+    return levels_.size();
+}
+
+std::size_t Overlay::cells(std::size_t level) const noexcept {
+    return levels_[level].cells;
+}
+
+// the overlay is only meaningful for the snapshot it was built for
+bool Overlay::fits(const CompactGraph& graph) const noexcept {
+    return generation_ == graph.generation() && order_ == graph.order() && size_ == graph.size();
+}
+
+Overlay::Weights Overlay::customize(const CompactGraph& graph, metrics::Metric metric,
+                                    ThreadPool* pool) const {
+    return customize(graph, metric, pool, nullptr);
+}
+
+// Cells of a level only depend on the level below, so they are customized in parallel.
+// When repairing, a cell is customized again if a changed arc shows on its level or one of its
+// cells below came out different, the others keep their cliques.
+Overlay::Weights Overlay::customize(const CompactGraph& graph, metrics::Metric metric,
+                                    ThreadPool* pool, const Reuse* reuse) const {
+    Weights weights(metric);
+    weights.cliques_.resize(levels_.size());
+    std::vector<bool> redo, differs;  // per cell of the level, when repairing
+    for (std::size_t l = 0; l < levels_.size(); l++) {
+        auto& level   = levels_[l];
+        auto& cliques = weights.cliques_[l];
+        cliques.assign(level.cliqueOffsets.back(), infinity);
+        if (reuse) {
+            redo = reuse->redo[l];
+            for (Vertex v = 0; l > 0 && v < graph.size(); v++)
+                if (differs[levels_[l - 1].cellOf[v]]) redo[level.cellOf[v]] = true;
+        }
+
+        // the previous clique of a cell, of the same boundary unless the cell is redone
+        auto previous = [&, l](std::uint32_t cell) {
+            auto& old = reuse->previous.levels_[l];
+            return ofCell(reuse->weights.cliques_[l], old.cliqueOffsets, cell);
+        };
+        auto customizeCells = [&, l](std::uint32_t first, std::uint32_t last) {
+            SearchTree tree;
+            for (auto cell = first; cell < last; cell++)
+                if (!reuse || redo[cell])
+                    customizeCell(graph, weights, l, cell, cliques, tree);
+                else
+                    std::ranges::copy(previous(cell), cliques.begin() + level.cliqueOffsets[cell]);
+        };
+        if (!pool || pool->size() < 2)
+            customizeCells(0, level.cells);
+        else {
+            std::uint32_t chunk = std::max<std::uint32_t>(1, level.cells / (4 * pool->size()));
+            std::vector<std::future<void>> tasks;
+            for (std::uint32_t first = 0; first < level.cells; first += chunk)
+                tasks.push_back(pool->submit([&customizeCells, first, chunk, &level] {
+                    customizeCells(first, std::min(first + chunk, level.cells));
+                }));
+            for (auto& task : tasks)
+                task.get();
+        }
+        if (!reuse) continue;
+
+        auto& old = reuse->previous.levels_[l];
+        differs.assign(level.cells, false);
+        for (std::uint32_t cell = 0; cell < level.cells; cell++) {
+            if (!redo[cell]) continue;
+            auto boundary = ofCell(level.boundary, level.boundaryOffsets, cell);
+            auto clique   = ofCell(cliques, level.cliqueOffsets, cell);
+            auto before   = ofCell(old.boundary, old.boundaryOffsets, cell);
+            differs[cell] = !std::ranges::equal(boundary, before)
+                         || !std::ranges::equal(clique, previous(cell));
+        }
+    }
+    return weights;
+}
+
+const Overlay::Weights& Overlay::weights(PathType type) const noexcept {
+    return profiles_[static_cast<std::size_t>(type)];
+}
+
+// Dijkstra over the overlay, the route is unpacked to vertices of the graph.
+double Overlay::search(const CompactGraph& graph, const Weights& weights, Vertex source,
+                       Vertex target, SearchTree& tree,
+                       std::vector<Vertex>& route) const {
+    auto metric = weights.metric_;
+    auto arcs   = [&](Vertex u, auto&& relax) {
+        auto l = queryLevel(u, source, target);
+        if (l == 0) {
+            graph.forEachNeighbour(
+                u, [&](Vertex v) { relax(v, metric(graph.point(u), graph.point(v))); });
+            return;
+        }
+
+        // u is a boundary point of its level l cell: the clique, then the connections leaving it
+        auto& level  = levels_[l - 1];
+        auto cell    = level.cellOf[u];
+        auto first   = level.boundaryOffsets[cell];
+        auto count   = level.boundaryOffsets[cell + 1] - first;
+        auto* clique = weights.cliques_[l - 1].data() + level.cliqueOffsets[cell]
+                     + std::size_t {level.boundaryIndex[u]} * count;
+        for (std::uint32_t j = 0; j < count; j++)
+            if (clique[j] != infinity) relax(level.boundary[first + j], clique[j]);
+        graph.forEachNeighbour(u, [&](Vertex v) {
+            if (level.cellOf[v] != cell) relax(v, metric(graph.point(u), graph.point(v)));
+        });
+    };
+    graphs::search(graph, std::views::single(source), arcs, graphs::noPotential,
+                   [target](Vertex u) { return u == target; }, tree);
+    double distance = tree.distance(target);  // unpacking searches again
+
+    route.clear();
+    auto hops = tree.path(target);
+    if (hops.empty()) return distance;
+    route.push_back(source);
+    for (std::size_t i = 1; i < hops.size(); i++) {
+        auto u = hops[i - 1], w = hops[i];
+        auto l = queryLevel(u, source, target);
+        if (l > 0 && levels_[l - 1].cellOf[u] == levels_[l - 1].cellOf[w])
+            unpack(graph, weights, l - 1, u, w, tree, route);
+        else
+            route.push_back(w);
+    }
+    return distance;
+}
+
+double Overlay::search(const CompactGraph& graph, PathType type, Vertex source, Vertex target,
+                       SearchTree& tree, std::vector<Vertex>& route) const {
+    return search(graph, weights(type), source, target, tree, route);
+}
+
+// Recursive coordinate bisection, splitting at the median of the wider extent.
+// A level l cell is the largest subtree holding at most cellSizes_[l] points, so cells nest.
+void Overlay::partition(const CompactGraph& graph, std::span<Vertex> vertices,
+                        std::size_t unassigned) {
+    for (; unassigned > 0 && vertices.size() <= cellSizes_[unassigned - 1]; unassigned--) {
+        auto& level = levels_[unassigned - 1];
+        for (auto v : vertices)
+            level.cellOf[v] = level.cells;
+        level.cells++;
+    }
+    if (unassigned == 0) return;
+
+    int minX = std::numeric_limits<int>::max(), maxX = std::numeric_limits<int>::min();
+    int minY = minX, maxY = maxX;
+    for (auto v : vertices) {
+        auto& point = graph.point(v);
+        minX        = std::min(minX, point.x);
+        maxX        = std::max(maxX, point.x);
+        minY        = std::min(minY, point.y);
+        maxY        = std::max(maxY, point.y);
+    }
+    bool byX    = std::int64_t {maxX} - minX >= std::int64_t {maxY} - minY;
+    auto middle = vertices.size() / 2;
+    std::ranges::nth_element(vertices, vertices.begin() + middle, {}, [&graph, byX](Vertex v) {
+        return byX ? graph.point(v).x : graph.point(v).y;
+    });
+    partition(graph, vertices.first(middle), unassigned);
+    partition(graph, vertices.subspan(middle), unassigned);
+}
+
+// boundary points have a connection to or from another cell of the same level
+void Overlay::findBoundaries(const CompactGraph& graph) {
+    for (auto& level : levels_) {
+        std::vector<bool> onBoundary(graph.size());
+        for (Vertex u = 0; u < graph.size(); u++)
+            graph.forEachNeighbour(u, [&](Vertex v) {
+                if (level.cellOf[u] != level.cellOf[v]) onBoundary[u] = onBoundary[v] = true;
+            });
+
+        level.boundaryOffsets.assign(level.cells + 1, 0);
+        for (Vertex v = 0; v < graph.size(); v++)
+            if (onBoundary[v]) level.boundaryOffsets[level.cellOf[v] + 1]++;
+        std::partial_sum(level.boundaryOffsets.begin(), level.boundaryOffsets.end(),
+                         level.boundaryOffsets.begin());
+
+        level.boundary.resize(level.boundaryOffsets.back());
+        level.boundaryIndex.assign(graph.size(), nidx);
+        auto fill = level.boundaryOffsets;
+        for (Vertex v = 0; v < graph.size(); v++) {
+            if (!onBoundary[v]) continue;
+            auto cell                    = level.cellOf[v];
+            level.boundaryIndex[v]       = fill[cell] - level.boundaryOffsets[cell];
+            level.boundary[fill[cell]++] = v;
+        }
+
+        level.cliqueOffsets.assign(level.cells + 1, 0);
+        for (std::uint32_t cell = 0; cell < level.cells; cell++) {
+            std::size_t count = level.boundaryOffsets[cell + 1] - level.boundaryOffsets[cell];
+            level.cliqueOffsets[cell + 1] = level.cliqueOffsets[cell] + count * count;
+        }
+    }
+}
+
+// Arcs of u inside a level l cell: the original connections on the lowest level, above the
+// clique of u's cell one level down and the connections between those cells.
+template<typename Relax>
+void Overlay::cellArcs(const CompactGraph& graph, const Weights& weights, std::size_t l,
+                       std::uint32_t cell, Vertex u, Relax&& relax) const {
+    auto& level = levels_[l];
+    auto metric = weights.metric_;
+    if (l == 0) {
+        graph.forEachNeighbour(u, [&](Vertex v) {
+            if (level.cellOf[v] == cell) relax(v, metric(graph.point(u), graph.point(v)));
+        });
+        return;
+    }
+
+    auto& lower   = levels_[l - 1];
+    auto subcell  = lower.cellOf[u];
+    auto subfirst = lower.boundaryOffsets[subcell];
+    auto subcount = lower.boundaryOffsets[subcell + 1] - subfirst;
+    auto* clique  = weights.cliques_[l - 1].data() + lower.cliqueOffsets[subcell]
+                  + std::size_t {lower.boundaryIndex[u]} * subcount;
+    for (std::uint32_t j = 0; j < subcount; j++)
+        if (clique[j] != infinity) relax(lower.boundary[subfirst + j], clique[j]);
+    graph.forEachNeighbour(u, [&](Vertex v) {
+        if (lower.cellOf[v] != subcell && level.cellOf[v] == cell)
+            relax(v, metric(graph.point(u), graph.point(v)));
+    });
+}
+
+// Distances between the boundary points of one cell, without leaving it.
+void Overlay::customizeCell(const CompactGraph& graph, const Weights& weights, std::size_t l,
+                            std::uint32_t cell, std::vector<double>& cliques,
+                            SearchTree& tree) const {
+    auto& level  = levels_[l];
+    auto first   = level.boundaryOffsets[cell];
+    auto count   = level.boundaryOffsets[cell + 1] - first;
+    auto* matrix = cliques.data() + level.cliqueOffsets[cell];
+
+    auto arcs = [&](Vertex u, auto&& relax) { cellArcs(graph, weights, l, cell, u, relax); };
+
+    // an arc whose path passes another boundary point is implied by the two arcs via that
+    // point, leaving it out (infinity) keeps the cliques sparse
+    auto implied = [&level, &tree](Vertex source, Vertex w) {
+        for (auto x = *tree.parent(w); x != source; x = *tree.parent(x))
+            if (level.boundaryIndex[x] != nidx) return true;
+        return false;
+    };
+    for (std::uint32_t i = 0; i < count; i++) {
+        auto source = level.boundary[first + i];
+        graphs::search(graph, std::views::single(source), arcs, graphs::noPotential,
+                       graphs::noGoal, tree);
+        for (std::uint32_t j = 0; j < count; j++) {
+            auto w = level.boundary[first + j];
+            if (tree.reached(w) && !implied(source, w))
+                matrix[std::size_t {i} * count + j] = tree.distance(w);
+        }
+    }
+}
+
+// Highest level whose cell of v holds neither the source nor the target, 0 for none.
+// Cells nest, so every level below separates v from both as well.
+std::size_t Overlay::queryLevel(Vertex v, Vertex source, Vertex target) const noexcept {
+    for (auto l = levels_.size(); l > 0; l--) {
+        auto& cellOf = levels_[l - 1].cellOf;
+        if (cellOf[v] != cellOf[source] && cellOf[v] != cellOf[target]) return l;
+    }
+    return 0;
+}
+
+// Replaces a clique arc u -> w of a level l cell with a shortest path inside the cell,
+// found over the level below and unpacked recursively.
+void Overlay::unpack(const CompactGraph& graph, const Weights& weights, std::size_t l, Vertex u,
+                     Vertex w, SearchTree& tree, std::vector<Vertex>& route) const {
+    auto cell = levels_[l].cellOf[u];
+    auto arcs = [&](Vertex x, auto&& relax) { cellArcs(graph, weights, l, cell, x, relax); };
+    graphs::search(graph, std::views::single(u), arcs, graphs::noPotential,
+                   [w](Vertex x) { return x == w; }, tree);
+
+    auto hops = tree.path(w);
+    for (std::size_t i = 1; i < hops.size(); i++) {
+        if (l > 0 && levels_[l - 1].cellOf[hops[i - 1]] == levels_[l - 1].cellOf[hops[i]])
+            unpack(graph, weights, l - 1, hops[i - 1], hops[i], tree, route);
+        else
+            route.push_back(hops[i]);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "CompactGraph.h"
+#include "Path.h"
+#include "ThreadPool.h"
+#include "metrics.h"
+
+namespace citymap
+{
+
+    /**
+     * Multi-level overlay in the style of customizable route planning (CRP).
+     *
+     * Preprocessing is split in two. The partition is metric independent: nested cells from
+     * recursive coordinate bisection, level l cells holding at most cellSize * fanout^(l-1)
+     * points, and per cell its boundary (points with a connection leaving or entering it).
+     * Customization turns any metric into Weights: per cell the distances between its boundary
+     * points, computed bottom up (level l from the cliques of level l-1) and cell parallel.
+     *
+     * A query scans the original connections only inside the cells of its source and target,
+     * elsewhere it moves over the cliques of the highest level that separates it from both.
+     * After connections change, only the cells whose cliques they can affect are customized again.
+     */
+    class Overlay {
+    public:
+        using Vertex = CompactGraph::Vertex;
+
+        // customized clique distances for one metric
+        class Weights {
+        public:
+            Weights() = default;
+
+            metrics::Metric metric() const noexcept;
+            bool empty() const noexcept;
+
+        private:
+            explicit Weights(metrics::Metric metric)
+                : metric_(metric) {}
+
+            metrics::Metric metric_ {};
+            std::vector<std::vector<double>> cliques_;  // per level, row major per cell
+
+            friend class Overlay;
+        };
+
+        static constexpr std::size_t defaultCellSize = 256;
+        static constexpr std::size_t defaultLevels   = 3;
+        static constexpr std::size_t fanout          = 8;
+
+        Overlay() = default;
+        Overlay(const CompactGraph&, ThreadPool* = nullptr, std::size_t = defaultCellSize,
+                std::size_t = defaultLevels);
+        Overlay(const Overlay&, const CompactGraph&, std::span<const std::pair<Vertex, Vertex>>,
+                ThreadPool* = nullptr);
+        ~Overlay() = default;
+
+        std::size_t levels() const noexcept;
+        std::size_t cells(std::size_t) const noexcept;
+        bool fits(const CompactGraph&) const noexcept;
+        Weights customize(const CompactGraph&, metrics::Metric, ThreadPool* = nullptr) const;
+        const Weights& weights(PathType) const noexcept;
+        double search(const CompactGraph&, const Weights&, Vertex, Vertex,
+                      SearchTree&, std::vector<Vertex>&) const;
+        double search(const CompactGraph&, PathType, Vertex, Vertex, SearchTree&,
+                      std::vector<Vertex>&) const;
+
+    private:
+        struct Level {
+            std::vector<std::uint32_t> cellOf;           // per vertex
+            std::vector<std::uint32_t> boundaryIndex;    // per vertex, position in its cell
+            std::vector<std::uint32_t> boundaryOffsets;  // per cell, into boundary
+            std::vector<Vertex> boundary;
+            std::vector<std::size_t> cliqueOffsets;      // per cell, into Weights::cliques_
+            std::uint32_t cells {};
+        };
+
+        // an overlay being repaired, cells not redone keep its cliques
+        struct Reuse {
+            const Overlay& previous;
+            const Weights& weights;
+            const std::vector<std::vector<bool>>& redo;  // per level and cell, in any case
+        };
+
+        static constexpr std::uint32_t nidx = static_cast<std::uint32_t>(-1);
+
+        Weights customize(const CompactGraph&, metrics::Metric, ThreadPool*, const Reuse*) const;
+        void partition(const CompactGraph&, std::span<Vertex>, std::size_t);
+        void findBoundaries(const CompactGraph&);
+        template<typename Relax>
+        void cellArcs(const CompactGraph&, const Weights&, std::size_t, std::uint32_t, Vertex,
+                      Relax&&) const;
+        void customizeCell(const CompactGraph&, const Weights&, std::size_t, std::uint32_t,
+                           std::vector<double>&, SearchTree&) const;
+        std::size_t queryLevel(Vertex, Vertex, Vertex) const noexcept;
+        void unpack(const CompactGraph&, const Weights&, std::size_t, Vertex, Vertex,
+                    SearchTree&, std::vector<Vertex>&) const;
+
+        std::vector<std::size_t> cellSizes_;
+        std::vector<Level> levels_;
+        std::array<Weights, 2> profiles_;
+        std::uint64_t generation_ {};
+        VertexOrder order_ {};
+        std::size_t size_ {};
+    };
+
+}  // namespace citymap
\ No newline at end of file
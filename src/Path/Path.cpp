@@ -1,10 +1,23 @@
 #include "Path.h"
+
+#include <utility>
+
 using namespace citymap;
 
 // Path
 
-Path::Path(double d, std::initializer_list<PointId> pts)
-    : distance_(d), points_(pts) {}
+Path::Path(const allocator_type& allocator)
+    : distance_(), points_(allocator) {}
+
+Path::Path(double d, std::initializer_list<PointId> pts, const allocator_type& allocator)
+    : distance_(d), points_(pts, allocator) {}
+
+Path::Path(double d, PointList pts)
+    : distance_(d), points_(std::move(pts)) {}
+
+// moves the points when they already live in the resource of the allocator, copies otherwise
+Path::Path(double d, PointList pts, const allocator_type& allocator)
+    : distance_(d), points_(std::move(pts), allocator) {}
 
 Path::operator double() const noexcept {
     return distance_;
@@ -22,20 +35,57 @@ const Path::PointList& Path::points() const noexcept {
     return points_;
 }
 
+// the first point, or the start of the query when the route was not found
 PointId Path::from() const noexcept {
-    return points_.front();
+    return points_.empty() ? from_ : points_.front();
 }
 
 PointId Path::to() const noexcept {
-    return points_.back();
+    return points_.empty() ? to_ : points_.back();
+}
+
+// endpoints of the query the path answers, reported by from() and to() while it has no points
+void Path::endpoints(PointId from, PointId to) noexcept {
+    from_ = from;
+    to_   = to;
+}
+
+// PathDeleter
+
+PathDeleter::PathDeleter(std::pmr::memory_resource* resource, std::size_t size,
+                         std::size_t alignment) noexcept
+    : resource_(resource), size_(size), alignment_(alignment) {}
+
+void PathDeleter::operator()(Path* path) const noexcept {
+    path->~Path();
+    resource_->deallocate(path, size_, alignment_);
 }
 
 // PedestrianPath
 
-PedestrianPath::PedestrianPath(double d, std::initializer_list<PointId> pts)
-    : Path(d, pts) {}
+PedestrianPath::PedestrianPath(const allocator_type& allocator)
+    : Path(allocator) {}
+
+PedestrianPath::PedestrianPath(double d, std::initializer_list<PointId> pts,
+                               const allocator_type& allocator)
+    : Path(d, pts, allocator) {}
+
+PedestrianPath::PedestrianPath(double d, PointList pts)
+    : Path(d, std::move(pts)) {}
+
+PedestrianPath::PedestrianPath(double d, PointList pts, const allocator_type& allocator)
+    : Path(d, std::move(pts), allocator) {}
 
 // CarPath
 
-CarPath::CarPath(double d, std::initializer_list<PointId> pts)
-    : Path(d, pts) {}
\ No newline at end of file
+CarPath::CarPath(const allocator_type& allocator)
+    : Path(allocator) {}
+
+CarPath::CarPath(double d, std::initializer_list<PointId> pts, const allocator_type& allocator)
+    : Path(d, pts, allocator) {}
+
+CarPath::CarPath(double d, PointList pts)
+    : Path(d, std::move(pts)) {}
+
+CarPath::CarPath(double d, PointList pts, const allocator_type& allocator)
+    : Path(d, std::move(pts), allocator) {}
\ No newline at end of file
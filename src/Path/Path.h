@@ -1,8 +1,11 @@
 #pragma once
 
+#include <cstddef>
 #include <initializer_list>
 #include <memory>
+#include <memory_resource>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "Point.h"
@@ -12,12 +15,17 @@ namespace citymap
 
     enum class PathType : unsigned char { Pedestrian, Car };
 
+    // Paths allocate their points from the resource they are given, e.g. the arena of a batch.
     class Path {
     public:
-        using PointList = std::vector<PointId>;
+        using PointList      = std::pmr::vector<PointId>;
+        using allocator_type = std::pmr::polymorphic_allocator<>;
 
         Path() = default;
-        Path(double, std::initializer_list<PointId>);
+        explicit Path(const allocator_type&);
+        Path(double, std::initializer_list<PointId>, const allocator_type& = {});
+        Path(double, PointList);
+        Path(double, PointList, const allocator_type&);
         virtual ~Path() = default;
 
         operator double() const noexcept;
@@ -26,6 +34,7 @@ namespace citymap
         const PointList& points() const noexcept;
         PointId from() const noexcept;
         PointId to() const noexcept;
+        void endpoints(PointId, PointId) noexcept;
 
         virtual constexpr operator PathType() const noexcept = 0;
         virtual constexpr PathType type() const noexcept = 0;
@@ -33,16 +42,38 @@ namespace citymap
     private:
         double distance_;
         PointList points_;
+        PointId from_ = static_cast<PointId>(-1);  // of the query, for a route that was not found
+        PointId to_   = static_cast<PointId>(-1);
 
         friend class Map;
     };
 
-    using PolymorphicPathList = std::vector<std::unique_ptr<Path>>;
+    // Destroys a path and hands its memory back to the resource it was allocated from.
+    class PathDeleter {
+    public:
+        PathDeleter() = default;
+        PathDeleter(std::pmr::memory_resource*, std::size_t, std::size_t) noexcept;
+
+        void operator()(Path*) const noexcept;
+
+    private:
+        std::pmr::memory_resource* resource_ {};
+        std::size_t size_ {}, alignment_ {};
+    };
+
+    using PathPtr             = std::unique_ptr<Path, PathDeleter>;
+    using PolymorphicPathList = std::pmr::vector<PathPtr>;
+
+    template<typename P, typename... Args>
+    PathPtr makePath(std::pmr::memory_resource*, Args&&...);
 
     class PedestrianPath final : public Path {
     public:
         PedestrianPath() = default;
-        PedestrianPath(double, std::initializer_list<PointId>);
+        explicit PedestrianPath(const allocator_type&);
+        PedestrianPath(double, std::initializer_list<PointId>, const allocator_type& = {});
+        PedestrianPath(double, PointList);
+        PedestrianPath(double, PointList, const allocator_type&);
         ~PedestrianPath() override = default;
 
         constexpr operator PathType() const noexcept override { return type(); }
@@ -52,11 +83,29 @@ namespace citymap
     class CarPath final : public Path {
     public:
         CarPath() = default;
-        CarPath(double, std::initializer_list<PointId>);
+        explicit CarPath(const allocator_type&);
+        CarPath(double, std::initializer_list<PointId>, const allocator_type& = {});
+        CarPath(double, PointList);
+        CarPath(double, PointList, const allocator_type&);
         ~CarPath() override = default;
 
         constexpr operator PathType() const noexcept override { return type(); }
         constexpr PathType type() const noexcept override { return PathType::Car; }
     };
 
+    // A P built in memory of the resource, its points allocated there as well.
+    template<typename P, typename... Args>
+    PathPtr makePath(std::pmr::memory_resource* resource, Args&&... args) {
+        std::pmr::polymorphic_allocator<P> allocator(resource);
+        auto* path = allocator.allocate(1);
+        try {
+            allocator.construct(path, std::forward<Args>(args)...);
+        }
+        catch (...) {
+            allocator.deallocate(path, 1);
+            throw;
+        }
+        return PathPtr(path, PathDeleter(resource, sizeof(P), alignof(P)));
+    }
+
 }  // namespace citymap
\ No newline at end of file
@@ -1,13 +1,14 @@
 #include "Query.h"
 
 #include <stdexcept>
+#include <utility>
 
 #include "Map.h"
 
 using namespace citymap;
 
 Query::Query(PointId from, PointId to)
-    : from_(from), to_(to) {}
+    : from_(from), to_(to), nearest_(Map::ncat) {}
 
 Query::Query(std::string_view from, std::string_view to, const Map& map)
     : Query(map.idOf(from), map.idOf(to)) {}
@@ -28,6 +29,31 @@ void Query::to(PointId id) noexcept {
     to_ = id;
 }
 
+// Map::ncat for an ordinary point to point query
+CategoryId Query::nearest() const noexcept {
+    return nearest_;
+}
+
+void Query::nearest(CategoryId category) noexcept {
+    nearest_ = category;
+}
+
+const std::vector<PointId>& Query::via() const noexcept {
+    return via_;
+}
+
+void Query::via(std::vector<PointId> points) noexcept {
+    via_ = std::move(points);
+}
+
+// from, the waypoints and to in route order
+std::vector<PointId> Query::stops() const {
+    std::vector<PointId> stops {from_};
+    stops.insert(stops.end(), via_.begin(), via_.end());
+    stops.push_back(to_);
+    return stops;
+}
+
 PedestrianQuery::PedestrianQuery(PointId from, PointId to)
     : Query(from, to) {}
 
@@ -89,10 +115,10 @@ UnifiedQuery::UnifiedQuery(UnifiedQuery&& other) noexcept
     : type_(other.type_) {
     switch (type_) {
         case PathType::Car:
-            new (&car_) CarQuery(other.car_);
+            new (&car_) CarQuery(std::move(other.car_));
             break;
         case PathType::Pedestrian:
-            new (&pd_) PedestrianQuery(other.pd_);
+            new (&pd_) PedestrianQuery(std::move(other.pd_));
             break;
     }
 }
@@ -117,6 +143,22 @@ void UnifiedQuery::to(PointId id) {
     get().to(id);
 }
 
+CategoryId UnifiedQuery::nearest() const {
+    return get().nearest();
+}
+
+void UnifiedQuery::nearest(CategoryId category) {
+    get().nearest(category);
+}
+
+const std::vector<PointId>& UnifiedQuery::via() const {
+    return get().via();
+}
+
+void UnifiedQuery::via(std::vector<PointId> points) {
+    get().via(std::move(points));
+}
+
 void UnifiedQuery::set(PointId from, PointId to, PathType type) {
     get().~Query();
     type_ = type;
@@ -137,7 +179,11 @@ void UnifiedQuery::set(std::string_view from, std::string_view to, const Map& ma
 }
 
 void UnifiedQuery::set(const Query& other) {
+    auto category = other.nearest();
+    auto points   = other.via();
     set(other.from(), other.to(), other.type());
+    nearest(category);
+    via(std::move(points));
 }
 
 Query& UnifiedQuery::get() {
@@ -165,6 +211,8 @@ const Query& UnifiedQuery::get() const {
 void UnifiedQuery::toggleType() {
     PointId from = this->from();
     PointId to = this->to();
+    CategoryId category = nearest();
+    auto points = via();
     get().~Query();
     switch (type_) {
         case PathType::Car:
@@ -178,6 +226,8 @@ void UnifiedQuery::toggleType() {
         default:
             throw std::logic_error("No suitable type.");
     }
+    nearest(category);
+    via(std::move(points));
 }
 
 PathType UnifiedQuery::type() const noexcept {
@@ -248,10 +298,10 @@ UnifiedQuery& UnifiedQuery::operator=(UnifiedQuery&& other) noexcept {
     type_ = other.type_;
     switch (type_) {
         case PathType::Car:
-            new (&car_) CarQuery(other.car_);
+            new (&car_) CarQuery(std::move(other.car_));
             break;
         case PathType::Pedestrian:
-            new (&pd_) PedestrianQuery(other.pd_);
+            new (&pd_) PedestrianQuery(std::move(other.pd_));
             break;
     }
     return *this;
@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <string_view>
+#include <vector>
 
 #include "Path.h"
 #include "Point.h"
@@ -21,12 +22,19 @@ namespace citymap
         PointId to() const noexcept;
         void from(PointId) noexcept;
         void to(PointId) noexcept;
+        CategoryId nearest() const noexcept;
+        void nearest(CategoryId) noexcept;
+        const std::vector<PointId>& via() const noexcept;
+        void via(std::vector<PointId>) noexcept;
+        std::vector<PointId> stops() const;
 
         virtual constexpr operator PathType() const noexcept = 0;
         virtual constexpr PathType type() const noexcept     = 0;
 
     private:
         PointId from_, to_;
+        CategoryId nearest_;  // route to the closest point of this category instead of to_
+        std::vector<PointId> via_;  // ordered waypoints between from_ and to_
     };
 
     using PolymorphicQueryList = std::vector<std::unique_ptr<Query>>;
@@ -66,6 +74,10 @@ namespace citymap
         PointId to() const;
         void from(PointId);
         void to(PointId);
+        CategoryId nearest() const;
+        void nearest(CategoryId);
+        const std::vector<PointId>& via() const;
+        void via(std::vector<PointId>);
         void set(PointId, PointId, PathType);
         void set(std::string_view, std::string_view, const Map&, PathType);
         void set(const Query&);
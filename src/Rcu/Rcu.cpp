@@ -0,0 +1,111 @@
+#include "Rcu.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace citymap;
+
+namespace
+{
+
+    constexpr std::uint64_t idle = 0;
+
+    // A thread's pinned epoch, on a cache line of its own. Slots are never freed, a thread
+    // exiting hands its slot over to the next one.
+    struct alignas(64) Slot {
+        std::atomic<std::uint64_t> epoch {idle};
+        std::atomic<bool> taken {};
+        Slot* next {};
+    };
+
+    struct Retired {
+        std::uint64_t epoch;
+        std::move_only_function<void()> reclaim;
+    };
+
+    std::atomic<Slot*> slots {};
+    std::atomic<std::uint64_t> globalEpoch {1};
+    std::mutex retiredMutex;
+    std::vector<Retired> retired;
+
+    Slot* claimSlot() {
+        for (auto slot = slots.load(std::memory_order_acquire); slot; slot = slot->next)
+            if (bool free = false; slot->taken.compare_exchange_strong(free, true)) return slot;
+
+        auto slot = new Slot;
+        slot->taken.store(true, std::memory_order_relaxed);
+        slot->next = slots.load(std::memory_order_relaxed);
+        while (!slots.compare_exchange_weak(slot->next, slot, std::memory_order_release)) {}
+        return slot;
+    }
+
+    struct Reader {
+        ~Reader() {
+            if (slot) slot->taken.store(false, std::memory_order_release);
+        }
+
+        Slot* slot {};
+        unsigned depth {};  // nested guards
+    };
+
+    thread_local Reader reader;
+
+    // oldest epoch still pinned, max when no reader is in a read section
+    std::uint64_t oldestPinned() {
+        auto oldest = std::numeric_limits<std::uint64_t>::max();
+        for (auto slot = slots.load(std::memory_order_acquire); slot; slot = slot->next)
+            if (auto pinned = slot->epoch.load(std::memory_order_seq_cst); pinned != idle)
+                oldest = std::min(oldest, pinned);
+        return oldest;
+    }
+
+    // Runs what was retired before every pinned epoch. Readers pinning later loaded the new
+    // versions: their epoch store precedes their load, which follows the swap.
+    void reclaim() {
+        std::vector<Retired> due;
+        {
+            std::scoped_lock lock(retiredMutex);
+            auto oldest  = oldestPinned();
+            auto safe    = [oldest](const Retired& entry) { return entry.epoch < oldest; };
+            auto pending = std::ranges::partition(retired, safe).begin();
+            std::move(retired.begin(), pending, std::back_inserter(due));
+            retired.erase(retired.begin(), pending);
+        }
+        for (auto& entry : due)
+            entry.reclaim();
+    }
+
+}  // namespace
+
+rcu::ReadGuard::ReadGuard() {
+    if (!reader.slot) reader.slot = claimSlot();
+    if (reader.depth++ > 0) return;
+    auto current = globalEpoch.load(std::memory_order_seq_cst);
+    reader.slot->epoch.store(current, std::memory_order_seq_cst);
+}
+
+rcu::ReadGuard::~ReadGuard() {
+    if (--reader.depth == 0) reader.slot->epoch.store(idle, std::memory_order_release);
+}
+
+// retired in the epoch that ends here, so readers pinned in it still hold the old version
+void rcu::retire(std::move_only_function<void()> reclaimer) {
+    {
+        std::scoped_lock lock(retiredMutex);
+        auto ended = globalEpoch.fetch_add(1, std::memory_order_seq_cst);
+        retired.push_back({ended, std::move(reclaimer)});
+    }
+    reclaim();
+}
+
+void rcu::synchronize() {
+    auto ended = globalEpoch.fetch_add(1, std::memory_order_seq_cst);
+    while (oldestPinned() <= ended)
+        std::this_thread::yield();
+    reclaim();
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <utility>
+
+namespace citymap::rcu
+{
+
+    /**
+     * Epoch based read-copy-update.
+     *
+     * A reader pins the current epoch in a slot of its thread for the length of a ReadGuard,
+     * without locks and writing only to that slot. A writer swaps in a new version and retires the
+     * old one, which is destroyed once every reader pinned at or before the swap has left its read
+     * section.
+     */
+    class ReadGuard {
+    public:
+        ReadGuard();
+        ReadGuard(const ReadGuard&) = delete;
+        ~ReadGuard();
+
+        ReadGuard& operator=(const ReadGuard&) = delete;
+    };
+
+    void retire(std::move_only_function<void()>);  // runs it after the readers of now are gone
+    void synchronize();                            // waits for the readers of now, then reclaims
+
+    // Latest published version of a T, read lock free and shared with the readers that took it.
+    // Taking it copies a shared_ptr, an atomic increment of a reference count all readers share.
+    template<typename T>
+    class Cell {
+    public:
+        Cell() = default;
+        Cell(const Cell&) = delete;
+        ~Cell() { delete current_.load(std::memory_order_relaxed); }
+
+        Cell& operator=(const Cell&) = delete;
+
+        std::shared_ptr<const T> load() const {
+            ReadGuard guard;
+            auto box = current_.load(std::memory_order_seq_cst);
+            return box ? box->value : nullptr;
+        }
+
+        void store(std::shared_ptr<const T> value) {
+            auto box = value ? new Box {std::move(value)} : nullptr;
+            if (auto old = current_.exchange(box, std::memory_order_seq_cst))
+                retire([old] { delete old; });
+        }
+
+    private:
+        // the shared_ptr itself cannot be read atomically, readers copy it out of a box that
+        // outlives them instead
+        struct Box {
+            std::shared_ptr<const T> value;
+        };
+
+        std::atomic<Box*> current_ {};
+    };
+
+}  // namespace citymap::rcu
\ No newline at end of file
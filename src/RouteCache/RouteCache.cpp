@@ -0,0 +1,91 @@
+#include "RouteCache.h"
+
+#include <functional>
+#include <utility>
+
+using namespace citymap;
+
+RouteCache::RouteCache(std::size_t capacity)
+    : capacity_(capacity) {}
+
+// pool is handed to the map for the legs of multi-stop queries, which are not cached. Entries
+// keep their own copy of the points, the path returned is allocated from the resource.
+PathPtr RouteCache::findPath(const Map& map, const Query& query, ThreadPool* pool,
+                             std::pmr::memory_resource* resource) {
+    // keyed by the endpoints only
+    if (query.nearest() != Map::ncat || !query.via().empty())
+        return map.findPath(query, pool, resource);
+    Key key {query.from(), query.to(), query.type()};
+    auto generation = map.compact()->generation();  // of the snapshot answering, not the map
+
+    {
+        std::scoped_lock lock(mutex_);
+        dropStale(generation);
+        if (auto it = index_.find(key); it != index_.end()) {
+            entries_.splice(entries_.begin(), entries_, it->second);
+            stats_.hits++;
+            auto path = makePath(key.type, it->second->distance, it->second->points, resource);
+            path->endpoints(key.from, key.to);
+            return path;
+        }
+        stats_.misses++;
+    }
+
+    auto path = map.findPath(query, nullptr, resource);
+
+    std::scoped_lock lock(mutex_);
+    dropStale(generation);
+    // skip the insert when the map changed meanwhile or another thread was faster
+    if (capacity_ == 0 || generation != generation_ || index_.contains(key)) return path;
+
+    entries_.emplace_front(key, generation, path->distance(), path->points());
+    index_.emplace(key, entries_.begin());
+    if (entries_.size() > capacity_) {
+        index_.erase(entries_.back().key);
+        entries_.pop_back();
+        stats_.evictions++;
+    }
+    return path;
+}
+
+RouteCache::Stats RouteCache::stats() const {
+    std::scoped_lock lock(mutex_);
+    return stats_;
+}
+
+std::size_t RouteCache::size() const {
+    std::scoped_lock lock(mutex_);
+    return entries_.size();
+}
+
+std::size_t RouteCache::capacity() const noexcept {
+    return capacity_;
+}
+
+void RouteCache::clear() {
+    std::scoped_lock lock(mutex_);
+    entries_.clear();
+    index_.clear();
+}
+
+std::size_t RouteCache::KeyHash::operator()(const Key& key) const noexcept {
+    std::size_t h = std::hash<PointId> {}(key.from);
+    h ^= std::hash<PointId> {}(key.to) + 0x9e3779b97f4a7c15 + (h << 6) + (h >> 2);
+    return h ^ static_cast<std::size_t>(key.type);
+}
+
+PathPtr RouteCache::makePath(PathType type, double distance, const Path::PointList& points,
+                             std::pmr::memory_resource* resource) {
+    if (type == PathType::Car) return citymap::makePath<CarPath>(resource, distance, points);
+    return citymap::makePath<PedestrianPath>(resource, distance, points);
+}
+
+// a newer map generation invalidates everything cached so far,
+// must be called with the mutex held
+void RouteCache::dropStale(std::uint64_t generation) {
+    if (generation <= generation_) return;
+    stats_.invalidations += entries_.size();
+    entries_.clear();
+    index_.clear();
+    generation_ = generation;
+}
\ No newline at end of file
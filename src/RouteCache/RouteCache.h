@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <unordered_map>
+
+#include "Map.h"
+#include "Path.h"
+#include "Query.h"
+
+namespace citymap
+{
+
+    /**
+     * Bounded LRU cache of resolved routes keyed by (from, to, PathType).
+     *
+     * Entries remember the generation of the map snapshot they were computed on, any map
+     * mutation makes them stale. Lookups and inserts are synchronized, searches run unlocked.
+     */
+    class RouteCache {
+    public:
+        struct Stats {
+            std::uint64_t hits;
+            std::uint64_t misses;
+            std::uint64_t invalidations;  // entries dropped because the map changed
+            std::uint64_t evictions;
+        };
+
+        explicit RouteCache(std::size_t);
+        ~RouteCache() = default;
+
+        PathPtr findPath(const Map&, const Query&, ThreadPool* = nullptr,
+                         std::pmr::memory_resource* = std::pmr::get_default_resource());
+        Stats stats() const;
+        std::size_t size() const;
+        std::size_t capacity() const noexcept;
+        void clear();
+
+    private:
+        struct Key {
+            PointId from, to;
+            PathType type;
+
+            bool operator==(const Key&) const = default;
+        };
+
+        struct KeyHash {
+            std::size_t operator()(const Key&) const noexcept;
+        };
+
+        struct Entry {
+            Key key;
+            std::uint64_t generation;
+            double distance;
+            Path::PointList points;
+        };
+
+        using EntryList = std::list<Entry>;
+
+        static PathPtr makePath(PathType, double, const Path::PointList&,
+                                std::pmr::memory_resource*);
+        void dropStale(std::uint64_t);
+
+        std::size_t capacity_;
+        mutable std::mutex mutex_;
+        EntryList entries_;  // most recently used first
+        std::unordered_map<Key, EntryList::iterator, KeyHash> index_;
+        std::uint64_t generation_ {};
+        Stats stats_ {};
+    };
+
+}  // namespace citymap
\ No newline at end of file
@@ -0,0 +1,423 @@
+#include "Server.h"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <memory_resource>
+#include <sstream>
+#include <string_view>
+#include <thread>
+
+using namespace citymap;
+
+static volatile std::sig_atomic_t stopRequested = 0;
+
+static void requestStop(int) {
+    stopRequested = 1;
+}
+
+namespace
+{
+
+    constexpr int pollInterval          = 200;  // ms, how often blocked readers check for shutdown
+    constexpr std::size_t maxLineLength = 64 * 1024;
+
+    constexpr std::string_view nearestPrefix = "nearest:";  // <from> nearest:<category>
+
+    class LineReader {
+    public:
+        explicit LineReader(int fd)
+            : fd_(fd) {}
+
+        // returns false on eof, error or shutdown
+        template<typename Pred>
+        bool next(std::string& line, Pred stopping) {
+            while (true) {
+                if (auto nl = buffer_.find('\n', scanned_); nl != std::string::npos) {
+                    line.assign(buffer_, 0, nl);
+                    buffer_.erase(0, nl + 1);
+                    scanned_ = 0;
+                    if (!line.empty() && line.back() == '\r') line.pop_back();
+                    return true;
+                }
+                scanned_ = buffer_.size();
+                if (eof_ || buffer_.size() > maxLineLength) break;
+
+                pollfd pfd {fd_, POLLIN, 0};
+                int ready = ::poll(&pfd, 1, pollInterval);
+                if (stopping()) return false;
+                if (ready < 0 && errno != EINTR) return false;
+                if (ready <= 0) continue;
+
+                char chunk[4096];
+                ssize_t count = ::read(fd_, chunk, sizeof(chunk));
+                if (count < 0 && errno != EINTR) return false;
+                if (count == 0) eof_ = true;
+                if (count > 0) buffer_.append(chunk, count);
+            }
+
+            // last line without a trailing newline
+            if (buffer_.empty() || buffer_.size() > maxLineLength) return false;
+            line.swap(buffer_);
+            buffer_.clear();
+            scanned_ = 0;
+            return true;
+        }
+
+        // the next line if it has been received completely, empty otherwise
+        std::string_view peek() const {
+            auto nl = buffer_.find('\n');
+            if (nl == std::string::npos) return {};
+            return std::string_view(buffer_).substr(0, nl);
+        }
+
+    private:
+        int fd_;
+        bool eof_ {};
+        std::string buffer_;
+        std::size_t scanned_ {};
+    };
+
+    bool isUpdate(std::string_view request) {
+        auto first = request.find_first_not_of(" \t");
+        return first != std::string_view::npos && (request[first] == '+' || request[first] == '-')
+               && request.substr(first + 1).starts_with(' ');
+    }
+
+    // a socket file left behind by a server that is gone: nobody accepts connections on it
+    bool staleSocket(const sockaddr_un& addr) {
+        struct stat info {};
+        if (::lstat(addr.sun_path, &info) != 0 || !S_ISSOCK(info.st_mode)) return false;
+        int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (probe < 0) return false;
+        bool refused = ::connect(probe, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0
+                    && errno == ECONNREFUSED;
+        ::close(probe);
+        return refused;
+    }
+
+    bool writeAll(int fd, std::string_view data) {
+        while (!data.empty()) {
+            ssize_t count = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+            if (count < 0 && errno == ENOTSOCK) count = ::write(fd, data.data(), data.size());
+            if (count < 0 && errno == EINTR) continue;
+            if (count <= 0) return false;
+            data.remove_prefix(count);
+        }
+        return true;
+    }
+
+}  // namespace
+
+Server::Server(Map& map, ThreadPool& pool, Tracer& tracer, RouteCache* cache)
+    : map_(map), tracer_(tracer), pool_(pool), cache_(cache), index_(map) {}
+
+Server::~Server() {
+    if (listenFd_ >= 0) {
+        ::close(listenFd_);
+        std::filesystem::remove(socketPath_);
+    }
+}
+
+void Server::defaultType(std::string_view type) {
+    defaultType_ = type;
+}
+
+void Server::listen(FilePathRef path) {
+    sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    if (path.native().size() >= sizeof(addr.sun_path)) {
+        err_ = "Socket path: " + path.string() + " is too long.";
+        return;
+    }
+    std::strcpy(addr.sun_path, path.c_str());
+
+    listenFd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd_ >= 0) {
+        if (staleSocket(addr)) ::unlink(addr.sun_path);
+        if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0
+            && ::listen(listenFd_, SOMAXCONN) == 0)
+        {
+            socketPath_ = path;
+            return;
+        }
+        ::close(listenFd_);
+        listenFd_ = -1;
+    }
+    err_ = "Could not listen on socket: " + path.string() + " (" + std::strerror(errno) + ")";
+}
+
+// Serves stdin/stdout and, when listening, socket clients.
+// Without a socket the server stops on stdin eof, otherwise on SIGINT/SIGTERM.
+void Server::run() {
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+
+    std::thread acceptor;
+    if (listenFd_ >= 0) acceptor = std::thread(&Server::acceptClients, this);
+
+    serve(STDIN_FILENO, STDOUT_FILENO);
+
+    if (acceptor.joinable()) {
+        while (!stopping())
+            ::poll(nullptr, 0, pollInterval);
+        acceptor.join();
+
+        std::unique_lock lock(clientsMutex_);
+        for (int fd : clients_)
+            ::shutdown(fd, SHUT_RDWR);
+        clientsDone_.wait(lock, [this] { return clients_.empty(); });
+    }
+}
+
+// Requests are read and dispatched to the pool as they arrive,
+// a writer thread sends the responses back in request order.
+void Server::serve(int in, int out) {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::future<std::string>> pending;
+    std::size_t running = 0;  // requests being answered by the pool
+    bool done = false, broken = false;
+
+    std::thread writer([&] {
+        std::string batch;
+        std::unique_lock lock(mutex);
+        while (true) {
+            changed.wait(lock, [&] { return done || !pending.empty(); });
+            if (pending.empty()) return;
+
+            auto front = std::move(pending.front());
+            pending.pop_front();
+            lock.unlock();
+            changed.notify_all();
+
+            batch = front.get();
+            // coalesce responses that are already available into one write
+            lock.lock();
+            while (!pending.empty()
+                   && pending.front().wait_for(std::chrono::seconds(0))
+                          == std::future_status::ready)
+            {
+                batch += pending.front().get();
+                pending.pop_front();
+            }
+            lock.unlock();
+
+            if (!writeAll(out, batch)) {
+                lock.lock();
+                broken = true;
+                changed.notify_all();
+                return;
+            }
+            lock.lock();
+        }
+    });
+
+    auto enqueue = [&](std::future<std::string> response) {
+        std::unique_lock lock(mutex);
+        changed.wait(lock, [&] { return broken || pending.size() < maxPending; });
+        if (broken) return false;
+        pending.push_back(std::move(response));
+        changed.notify_all();
+        return true;
+    };
+
+    LineReader reader(in);
+    std::string line;
+    std::vector<std::string> updates;
+    auto stop = [this] { return stopping(); };
+    while (reader.next(line, stop)) {
+        if (line.find_first_not_of(" \t") == std::string::npos) continue;
+
+        // Updates in line, once the requests read before them are answered, so only the requests
+        // read after them see the change. Those received back to back are applied together, as
+        // one new version of the map.
+        if (isUpdate(line)) {
+            updates.assign(1, line);
+            while (isUpdate(reader.peek()) && reader.next(line, stop))
+                updates.push_back(line);
+            {
+                std::unique_lock lock(mutex);
+                changed.wait(lock, [&] { return running == 0; });
+            }
+            bool sent = true;
+            for (auto& response : update(updates)) {
+                std::promise<std::string> ready;
+                ready.set_value(response + '\n');
+                sent = sent && enqueue(ready.get_future());
+            }
+            if (!sent) break;
+            continue;
+        }
+
+        auto respond = [&, line] {
+            std::string response;
+            try {
+                response = answer(line) + '\n';
+            }
+            catch (const std::exception& e) {
+                response = std::string("error ") + e.what() + '\n';
+            }
+            std::scoped_lock lock(mutex);
+            running--;
+            changed.notify_all();
+            return response;
+        };
+        {
+            std::scoped_lock lock(mutex);
+            running++;
+        }
+        if (!enqueue(pool_.submit(respond))) break;
+    }
+
+    {
+        std::scoped_lock lock(mutex);
+        done = true;
+    }
+    changed.notify_all();
+    writer.join();
+}
+
+// The paths of a request are allocated from an arena of the answering thread, reset for the next
+// one. Its first block is a thread_local buffer, most routes never reach the heap.
+std::string Server::answer(std::string_view request) const {
+    thread_local std::array<std::byte, 16 * 1024> buffer;
+    thread_local std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size());
+    arena.release();  // the paths of the previous request are gone
+    if (isUpdate(request)) {
+        std::string line(request);
+        return update({&line, 1}).front();
+    }
+
+    std::istringstream tokens {std::string(request)};
+    std::string from, to, type, extra;
+    tokens >> from >> to >> type >> extra;
+    if (type.empty()) type = defaultType_;
+
+    if (to.empty() || !extra.empty()) return "error expected: <from> <to> [Car|Pedestrian|Both]";
+    if (type != "Car" && type != "Pedestrian" && type != "Both")
+        return "error unknown route type: " + type;
+    auto fromId = resolve(from);
+    if (fromId == Map::npnt) return "error unknown point: " + from;
+
+    UnifiedQuery query(fromId, Map::npnt,
+                       type == "Pedestrian" ? PathType::Pedestrian : PathType::Car);
+    if (to.starts_with(nearestPrefix)) {
+        auto name     = to.substr(nearestPrefix.size());
+        auto category = map_.findCategory(name);
+        if (category == Map::ncat) return "error unknown category: " + name;
+        query.nearest(category);
+    }
+    else if (auto toId = resolve(to); toId != Map::npnt)
+        query.to(toId);
+    else
+        return "error unknown point: " + to;
+    std::string response;
+    for (int i = 0; i < (type == "Both" ? 2 : 1); i++) {
+        if (i) {
+            query.toggleType();
+            response += " | ";
+        }
+        auto begin = Tracer::Clock::now();
+        auto path  = cache_ ? cache_->findPath(map_, query, nullptr, &arena)
+                            : map_.findPath(query, nullptr, &arena);
+        tracer_.recordQuery(query.type(), begin, Tracer::Clock::now(), request);
+        appendPath(response, *path);
+    }
+    return response;
+}
+
+bool Server::fail() const noexcept {
+    return !err_.empty();
+}
+
+const std::string& Server::error() const noexcept {
+    return err_;
+}
+
+void Server::acceptClients() {
+    while (!stopping()) {
+        pollfd pfd {listenFd_, POLLIN, 0};
+        if (::poll(&pfd, 1, pollInterval) <= 0) continue;
+
+        int client = ::accept(listenFd_, nullptr, nullptr);
+        if (client < 0) continue;
+
+        // detached, run() waits for clients_ to drain instead of joining
+        std::scoped_lock lock(clientsMutex_);
+        clients_.insert(client);
+        std::thread([this, client] {
+            serve(client, client);
+            std::scoped_lock lock(clientsMutex_);
+            clients_.erase(client);
+            ::close(client);
+            if (clients_.empty()) clientsDone_.notify_all();
+        }).detach();
+    }
+}
+
+// Connection changes, published to the queries as one new snapshot of the map.
+// Returns the response to each request, malformed ones are left out of the batch.
+std::vector<std::string> Server::update(std::span<const std::string> requests) const {
+    std::vector<std::string> responses;
+    std::vector<Map::ConnectionChange> changes;
+    for (auto& request : requests) {
+        std::istringstream tokens {request};
+        std::string op, from, to, extra;
+        tokens >> op >> from >> to >> extra;
+        auto fromId = resolve(from);
+        auto toId   = resolve(to);
+        if (to.empty() || !extra.empty())
+            responses.push_back("error expected: +|- <from> <to>");
+        else if (fromId == Map::npnt)
+            responses.push_back("error unknown point: " + from);
+        else if (toId == Map::npnt)
+            responses.push_back("error unknown point: " + to);
+        else {
+            responses.push_back("ok");
+            changes.push_back({fromId, toId, op == "+"});
+        }
+    }
+
+    try {
+        map_.update(changes);
+    }
+    catch (const std::exception& e) {
+        for (auto& response : responses)
+            if (response == "ok") response = std::string("error ") + e.what();
+    }
+    return responses;
+}
+
+// point name or "@x,y" snapped to the nearest point
+PointId Server::resolve(std::string_view token) const {
+    if (Point location; token.starts_with('@'))
+        return parseCoordinates(token, location) ? index_.nearest(location) : Map::npnt;
+    return map_.find(token);
+}
+
+bool Server::stopping() const noexcept {
+    return stopRequested != 0;
+}
+
+void Server::appendPath(std::string& out, const Path& path) const {
+    out += path.type() == PathType::Car ? "Car " : "Pedestrian ";
+    if (path.points().empty()) {
+        out += "none";
+        return;
+    }
+    std::ostringstream distance;
+    distance << path.distance();
+    out += distance.str() + ' ' + map_.describe(path.points(), " ");
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "Map.h"
+#include "RouteCache.h"
+#include "SpatialIndex.h"
+#include "ThreadPool.h"
+#include "Tracer.h"
+
+namespace citymap
+{
+
+    /**
+     * Answers route requests against a resident map.
+     *
+     * Protocol (newline delimited, one response line per request line):
+     *   request:  <from> <to> [Car|Pedestrian|Both]   (points by name or as @x,y)
+     *   response: <type> <distance> <point>... [| <type> <distance> <point>...]
+     *             <type> none                   (no route)
+     *             error <message>
+     *   update:   +|- <from> <to>               (adds / removes the connection)
+     *   response: ok
+     * Requests may be pipelined, responses keep the request order of their connection.
+     * An update is applied after the earlier requests of its connection are answered and before
+     * any later one is, queries of other connections running meanwhile finish on the previous
+     * version of the map. Updates received back to back are applied together.
+     */
+    class Server {
+        using FilePathRef = const std::filesystem::path&;
+
+    public:
+        Server(Map&, ThreadPool&, Tracer&, RouteCache* = nullptr);
+        Server(const Server&) = delete;
+        ~Server();
+
+        Server& operator=(const Server&) = delete;
+
+        void defaultType(std::string_view);
+        void listen(FilePathRef);
+        void run();
+        void serve(int, int);
+        std::string answer(std::string_view) const;
+        bool fail() const noexcept;
+        const std::string& error() const noexcept;
+
+    protected:
+        static constexpr std::size_t maxPending = 1024;
+
+        void acceptClients();
+        std::vector<std::string> update(std::span<const std::string>) const;
+        PointId resolve(std::string_view) const;
+        bool stopping() const noexcept;
+        void appendPath(std::string&, const Path&) const;
+
+    private:
+        Map& map_;
+        Tracer& tracer_;
+        ThreadPool& pool_;
+        RouteCache* cache_;
+        SpatialIndex index_;
+        std::string defaultType_ {"Both"};
+        std::string err_;
+        std::filesystem::path socketPath_;
+        int listenFd_ {-1};
+        std::mutex clientsMutex_;
+        std::unordered_set<int> clients_;  // served by detached threads
+        std::condition_variable clientsDone_;
+    };
+
+}  // namespace citymap
\ No newline at end of file
@@ -0,0 +1,213 @@
+#include "ShortestPathTrees.h"
+
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <limits>
+
+#include "DeltaStepping.h"
+#include "Map.h"
+
+using namespace citymap;
+
+static constexpr double infinity = std::numeric_limits<double>::infinity();
+
+ShortestPathTrees::ShortestPathTrees(const CompactGraph& graph, std::span<const Vertex> sources,
+                                     ThreadPool* pool) {
+    bind(graph);
+    for (auto v : sources)
+        if (v < graph.size()) sources_.push_back(v);
+    std::ranges::sort(sources_);
+    auto [first, last] = std::ranges::unique(sources_);
+    sources_.erase(first, last);
+
+    for (auto& trees : trees_)
+        trees.resize(sources_.size());
+    if (DeltaStepping::pays(graph, pool)) {  // one tree after another, each spread over the pool
+        DeltaStepping engine(*pool);
+        for (auto type : {PathType::Pedestrian, PathType::Car})
+            for (std::size_t i = 0; i < sources_.size(); i++) {
+                engine.run(graph, sources_[i], Map::metricOf(type));
+                auto& tree = trees_[indexOf(type)][i];
+                tree.resize(graph.size());
+                for (Vertex v = 0; v < graph.size(); v++)
+                    tree[v] = {engine.distance(v), engine.parent(v)};
+            }
+        return;
+    }
+    auto build = [this, &graph](std::size_t i) {
+        for (auto type : {PathType::Pedestrian, PathType::Car})
+            compute(graph, sources_[i], type, trees_[indexOf(type)][i]);
+    };
+    if (!pool) {
+        for (std::size_t i = 0; i < sources_.size(); i++)
+            build(i);
+        return;
+    }
+    std::vector<std::future<void>> tasks;
+    for (std::size_t i = 0; i < sources_.size(); i++)
+        tasks.push_back(pool->submit([&build, i] { build(i); }));
+    for (auto& task : tasks)
+        task.get();
+}
+
+// Repairs previous for graph, a patch of its snapshot with the inserted arcs added and the
+// removed ones gone. Removals go first, so every label is the length of a path of the patch again.
+// Lowering whatever the inserted arcs improve then leaves every arc satisfying the triangle
+// inequality, which makes the distances exact.
+ShortestPathTrees::ShortestPathTrees(const ShortestPathTrees& previous, const CompactGraph& graph,
+                                     std::span<const Arc> inserted, std::span<const Arc> removed)
+    : sources_(previous.sources_), trees_(previous.trees_) {
+    bind(graph);
+    std::vector<Vertex> affected;
+    std::vector<bool> inSubtree(graph.size());
+    for (auto type : {PathType::Pedestrian, PathType::Car})
+        for (auto& tree : trees_[indexOf(type)]) {
+            for (auto arc : removed)
+                repairRemoval(graph, type, tree, arc, affected, inSubtree);
+            repairInsertions(graph, type, tree, inserted);
+        }
+}
+
+bool ShortestPathTrees::empty() const noexcept {
+    return sources_.empty();
+}
+
+// the trees are only meaningful for the snapshot they were computed or repaired for
+bool ShortestPathTrees::fits(const CompactGraph& graph) const noexcept {
+    return !empty() && generation_ == graph.generation() && order_ == graph.order()
+        && size_ == graph.size();
+}
+
+bool ShortestPathTrees::pinned(Vertex source) const noexcept {
+    return std::ranges::binary_search(sources_, source);
+}
+
+const std::vector<ShortestPathTrees::Vertex>& ShortestPathTrees::sources() const noexcept {
+    return sources_;
+}
+
+// from a pinned source, infinity when the target is unreachable
+double ShortestPathTrees::distance(Vertex source, Vertex target, PathType type) const noexcept {
+    return treeOf(source, type)[target].distance;
+}
+
+// Vertices from a pinned source to the target, empty when it is unreachable. Returns the distance.
+double ShortestPathTrees::route(Vertex source, Vertex target, PathType type,
+                                std::vector<Vertex>& route) const {
+    auto& tree = treeOf(source, type);
+    route.clear();
+    if (tree[target].parent == CompactGraph::nvtx) return infinity;
+    for (auto v = target; v != source; v = tree[v].parent)
+        route.push_back(v);
+    route.push_back(source);
+    std::ranges::reverse(route);
+    return tree[target].distance;
+}
+
+// labels the repair this version came from settled again, over all trees
+std::size_t ShortestPathTrees::repaired() const noexcept {
+    return repaired_;
+}
+
+std::size_t ShortestPathTrees::indexOf(PathType type) noexcept {
+    return static_cast<std::size_t>(type);
+}
+
+const ShortestPathTrees::Tree& ShortestPathTrees::treeOf(Vertex source,
+                                                         PathType type) const noexcept {
+    auto i = std::ranges::lower_bound(sources_, source) - sources_.begin();
+    return trees_[indexOf(type)][static_cast<std::size_t>(i)];
+}
+
+void ShortestPathTrees::compute(const CompactGraph& graph, Vertex source, PathType type,
+                                Tree& tree) const {
+    SearchTree search;
+    graphs::search(graph, std::views::single(source), graph.arcs(Map::metricOf(type)),
+                   graphs::noPotential, graphs::noGoal, search);
+    tree.resize(graph.size());
+    for (Vertex v = 0; v < graph.size(); v++)
+        tree[v] = {search.distance(v), search.parent(v).value_or(CompactGraph::nvtx)};
+}
+
+// Removing a tree arc a -> b detaches exactly the subtree of b. Its labels are reseeded from the
+// best in-neighbour outside of it and settled again. An inserted arc can make a reseeded label
+// shorter than before, so that decrease goes on past the subtree like the ones of insertions.
+void ShortestPathTrees::repairRemoval(const CompactGraph& graph, PathType type, Tree& tree,
+                                      Arc arc, std::vector<Vertex>& affected,
+                                      std::vector<bool>& inSubtree) {
+    auto [a, b] = arc;
+    if (a == b || tree[b].parent != a) return;
+
+    auto metric = Map::metricOf(type);
+    affected.assign(1, b);
+    inSubtree[b] = true;
+    for (std::size_t i = 0; i < affected.size(); i++) {
+        auto u = affected[i];
+        graph.forEachNeighbour(u, [&](Vertex v) {
+            if (!inSubtree[v] && tree[v].parent == u) {
+                inSubtree[v] = true;
+                affected.push_back(v);
+            }
+        });
+    }
+
+    for (auto v : affected) {
+        Label best {infinity, CompactGraph::nvtx};
+        graph.forEachIncoming(v, [&](Vertex u) {
+            if (inSubtree[u] || tree[u].parent == CompactGraph::nvtx) return;
+            double candidate = tree[u].distance + metric(graph.point(u), graph.point(v));
+            if (candidate < best.distance) best = {candidate, u};
+        });
+        tree[v] = best;
+    }
+    for (auto v : affected)
+        inSubtree[v] = false;
+
+    std::vector<Entry> heap;
+    for (auto v : affected)
+        if (tree[v].parent != CompactGraph::nvtx) heap.push_back({tree[v].distance, v});
+    std::ranges::make_heap(heap, std::greater {});
+    lower(graph, metric, tree, heap);
+}
+
+// Lowers the labels an inserted arc improves.
+void ShortestPathTrees::repairInsertions(const CompactGraph& graph, PathType type, Tree& tree,
+                                         std::span<const Arc> inserted) {
+    auto metric = Map::metricOf(type);
+    std::vector<Entry> heap;
+    for (auto [a, b] : inserted) {
+        double distance = tree[a].distance + metric(graph.point(a), graph.point(b));
+        if (distance >= tree[b].distance) continue;
+        tree[b] = {distance, a};
+        heap.push_back({distance, b});
+    }
+    std::ranges::make_heap(heap, std::greater {});
+    lower(graph, metric, tree, heap);
+}
+
+// Settles the vertices on the heap in Dijkstra order and lowers their out-neighbours they improve,
+// only the vertices whose distance drops are visited.
+void ShortestPathTrees::lower(const CompactGraph& graph, metrics::Metric metric, Tree& tree,
+                              std::vector<Entry>& heap) {
+    while (!heap.empty()) {
+        std::ranges::pop_heap(heap, std::greater {});
+        auto [distance, u] = heap.back();
+        heap.pop_back();
+        if (distance > tree[u].distance) continue;  // stale entry
+        repaired_++;
+        graph.forEachNeighbour(u, [&](Vertex v) {
+            double candidate = distance + metric(graph.point(u), graph.point(v));
+            if (candidate >= tree[v].distance) return;
+            tree[v] = {candidate, u};
+            heap.push_back({candidate, v});
+            std::ranges::push_heap(heap, std::greater {});
+        });
+    }
+}
+
+void ShortestPathTrees::bind(const CompactGraph& graph) noexcept {
+    generation_ = graph.generation();
+    order_      = graph.order();
+    size_       = graph.size();
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "CompactGraph.h"
+#include "Path.h"
+#include "ThreadPool.h"
+
+namespace citymap
+{
+
+    /**
+     * Shortest path trees of pinned sources (e.g. depots), for both path types.
+     *
+     * They belong to one CompactGraph snapshot and are repaired for a patch of it in the style of
+     * Ramalingam and Reps instead of being searched again. A removed tree arc only detaches the
+     * subtree below it, which is settled again from its remaining in-neighbours. An inserted arc
+     * only lowers the distances it improves, propagated while they keep improving.
+     */
+    class ShortestPathTrees {
+    public:
+        using Vertex = CompactGraph::Vertex;
+        using Arc    = std::pair<Vertex, Vertex>;
+
+        ShortestPathTrees() = default;
+        ShortestPathTrees(const CompactGraph&, std::span<const Vertex>, ThreadPool* = nullptr);
+        ShortestPathTrees(const ShortestPathTrees&, const CompactGraph&, std::span<const Arc>,
+                          std::span<const Arc>);
+        ~ShortestPathTrees() = default;
+
+        bool empty() const noexcept;
+        bool fits(const CompactGraph&) const noexcept;
+        bool pinned(Vertex) const noexcept;
+        const std::vector<Vertex>& sources() const noexcept;
+        double distance(Vertex, Vertex, PathType) const noexcept;
+        double route(Vertex, Vertex, PathType, std::vector<Vertex>&) const;
+        std::size_t repaired() const noexcept;
+
+    private:
+        struct Label {
+            double distance;
+            Vertex parent;  // nvtx when unreached, the source is its own parent
+        };
+
+        using Tree  = std::vector<Label>;
+        using Entry = std::pair<double, Vertex>;  // of the repair heaps
+
+        static std::size_t indexOf(PathType) noexcept;
+
+        const Tree& treeOf(Vertex, PathType) const noexcept;
+        void compute(const CompactGraph&, Vertex, PathType, Tree&) const;
+        void repairRemoval(const CompactGraph&, PathType, Tree&, Arc, std::vector<Vertex>&,
+                           std::vector<bool>&);
+        void repairInsertions(const CompactGraph&, PathType, Tree&, std::span<const Arc>);
+        void lower(const CompactGraph&, metrics::Metric, Tree&, std::vector<Entry>&);
+        void bind(const CompactGraph&) noexcept;
+
+        std::vector<Vertex> sources_;             // ascending
+        std::array<std::vector<Tree>, 2> trees_;  // per path type, one per source
+        std::uint64_t generation_ {};
+        VertexOrder order_ {};
+        std::size_t size_ {};
+        std::size_t repaired_ {};
+    };
+
+}  // namespace citymap
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include "SpatialIndex.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <limits>
+
+#include "Map.h"
+
+using namespace citymap;
+
+SpatialIndex::SpatialIndex(const Map& map) {
+    build(map);
+}
+
+void SpatialIndex::build(const Map& map) {
+    struct Entry {
+        int x, y;
+        PointId id;
+    };
+
+    std::vector<Entry> entries;
+    entries.reserve(map.size());
+    for (auto id : map.ids()) {
+        auto& val = map.valueOf(id);
+        entries.emplace_back(val.x, val.y, id);
+    }
+
+    // median split of every range, alternating the axis with depth
+    auto split = [&entries](auto& self, std::size_t lo, std::size_t hi, std::size_t depth) {
+        if (hi - lo <= leafSize) return;
+        auto mid = lo + (hi - lo) / 2;
+        std::nth_element(entries.begin() + lo, entries.begin() + mid, entries.begin() + hi,
+                         [depth](const Entry& a, const Entry& b) {
+                             return depth % 2 ? a.y < b.y : a.x < b.x;
+                         });
+        self(self, lo, mid, depth + 1);
+        self(self, mid + 1, hi, depth + 1);
+    };
+    split(split, 0, entries.size(), 0);
+
+    xs_.resize(entries.size());
+    ys_.resize(entries.size());
+    ids_.resize(entries.size());
+    for (std::size_t i = 0; i < entries.size(); i++) {
+        xs_[i]  = entries[i].x;
+        ys_[i]  = entries[i].y;
+        ids_[i] = entries[i].id;
+    }
+}
+
+PointId SpatialIndex::nearest(Point pt) const {
+    Candidate best {std::numeric_limits<std::int64_t>::max(), Map::npnt};
+    nearest(0, size(), 0, pt, best);
+    return best.id;
+}
+
+// k nearest points, closest first
+std::vector<PointId> SpatialIndex::nearest(Point pt, std::size_t k) const {
+    std::vector<Candidate> heap;
+    if (k == 0) return {};
+    heap.reserve(k + 1);
+    nearest(0, size(), 0, pt, k, heap);
+
+    std::ranges::sort_heap(heap);
+    std::vector<PointId> result;
+    result.reserve(heap.size());
+    for (auto& c : heap)
+        result.push_back(c.id);
+    return result;
+}
+
+// points within the euclidean radius (inclusive), in no particular order
+std::vector<PointId> SpatialIndex::within(Point pt, double radius) const {
+    std::vector<PointId> result;
+    if (radius < 0) return result;
+    auto limit = static_cast<std::int64_t>(std::floor(radius * radius));
+    within(0, size(), 0, pt, limit, result);
+    return result;
+}
+
+std::size_t SpatialIndex::size() const noexcept {
+    return ids_.size();
+}
+
+bool SpatialIndex::empty() const noexcept {
+    return ids_.empty();
+}
+
+std::int64_t SpatialIndex::distanceTo(std::size_t i, Point pt) const noexcept {
+    std::int64_t dx = std::int64_t {xs_[i]} - pt.x;
+    std::int64_t dy = std::int64_t {ys_[i]} - pt.y;
+    return dx * dx + dy * dy;
+}
+
+// signed offset of the point from the splitting plane of a node
+std::int64_t SpatialIndex::splitOffset(std::size_t node, std::size_t depth,
+                                       Point pt) const noexcept {
+    return depth % 2 ? std::int64_t {pt.y} - ys_[node] : std::int64_t {pt.x} - xs_[node];
+}
+
+void SpatialIndex::nearest(std::size_t lo, std::size_t hi, std::size_t depth, Point pt,
+                           Candidate& best) const {
+    if (hi - lo <= leafSize) {
+        for (auto i = lo; i < hi; i++)
+            best = std::min(best, Candidate {distanceTo(i, pt), ids_[i]});
+        return;
+    }
+
+    auto mid    = lo + (hi - lo) / 2;
+    auto offset = splitOffset(mid, depth, pt);
+    best        = std::min(best, Candidate {distanceTo(mid, pt), ids_[mid]});
+
+    if (offset < 0) {
+        nearest(lo, mid, depth + 1, pt, best);
+        if (offset * offset <= best.distance) nearest(mid + 1, hi, depth + 1, pt, best);
+    }
+    else {
+        nearest(mid + 1, hi, depth + 1, pt, best);
+        if (offset * offset <= best.distance) nearest(lo, mid, depth + 1, pt, best);
+    }
+}
+
+// heap is a max-heap of the k best candidates found so far
+void SpatialIndex::nearest(std::size_t lo, std::size_t hi, std::size_t depth, Point pt,
+                           std::size_t k, std::vector<Candidate>& heap) const {
+    auto offer = [&](std::size_t i) {
+        Candidate c {distanceTo(i, pt), ids_[i]};
+        if (heap.size() < k) {
+            heap.push_back(c);
+            std::ranges::push_heap(heap);
+        }
+        else if (c < heap.front()) {
+            std::ranges::pop_heap(heap);
+            heap.back() = c;
+            std::ranges::push_heap(heap);
+        }
+    };
+    auto worst = [&] {
+        return heap.size() < k ? std::numeric_limits<std::int64_t>::max() : heap.front().distance;
+    };
+
+    if (hi - lo <= leafSize) {
+        for (auto i = lo; i < hi; i++)
+            offer(i);
+        return;
+    }
+
+    auto mid    = lo + (hi - lo) / 2;
+    auto offset = splitOffset(mid, depth, pt);
+    offer(mid);
+
+    if (offset < 0) {
+        nearest(lo, mid, depth + 1, pt, k, heap);
+        if (offset * offset <= worst()) nearest(mid + 1, hi, depth + 1, pt, k, heap);
+    }
+    else {
+        nearest(mid + 1, hi, depth + 1, pt, k, heap);
+        if (offset * offset <= worst()) nearest(lo, mid, depth + 1, pt, k, heap);
+    }
+}
+
+void SpatialIndex::within(std::size_t lo, std::size_t hi, std::size_t depth, Point pt,
+                          std::int64_t limit, std::vector<PointId>& result) const {
+    if (hi - lo <= leafSize) {
+        for (auto i = lo; i < hi; i++)
+            if (distanceTo(i, pt) <= limit) result.push_back(ids_[i]);
+        return;
+    }
+
+    auto mid    = lo + (hi - lo) / 2;
+    auto offset = splitOffset(mid, depth, pt);
+    if (distanceTo(mid, pt) <= limit) result.push_back(ids_[mid]);
+
+    if (offset <= 0 || offset * offset <= limit) within(lo, mid, depth + 1, pt, limit, result);
+    if (offset >= 0 || offset * offset <= limit) within(mid + 1, hi, depth + 1, pt, limit, result);
+}
+
+bool citymap::parseCoordinates(std::string_view token, Point& pt) noexcept {
+    if (!token.starts_with('@')) return false;
+    const char* end = token.data() + token.size();
+
+    auto [comma, ec] = std::from_chars(token.data() + 1, end, pt.x);
+    if (ec != std::errc {} || comma == end || *comma != ',') return false;
+    auto [last, ec2] = std::from_chars(comma + 1, end, pt.y);
+    return ec2 == std::errc {} && last == end;
+}
\ No newline at end of file
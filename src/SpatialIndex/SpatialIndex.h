@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "Point.h"
+
+namespace citymap
+{
+
+    class Map;
+
+    /**
+     * Static 2-d tree over the map's point coordinates.
+     *
+     * The tree is implicit: points are stored (SoA) in median-split order, so the node
+     * of a range [lo, hi) is its middle element and splits alternate between x and y.
+     * Bulk build is O(n log n), nearest lookups are O(log n) on average.
+     */
+    class SpatialIndex {
+    public:
+        SpatialIndex() = default;
+        explicit SpatialIndex(const Map&);
+        ~SpatialIndex() = default;
+
+        void build(const Map&);
+        PointId nearest(Point) const;
+        std::vector<PointId> nearest(Point, std::size_t) const;
+        std::vector<PointId> within(Point, double) const;
+        std::size_t size() const noexcept;
+        bool empty() const noexcept;
+
+    private:
+        struct Candidate {
+            std::int64_t distance;
+            PointId id;
+
+            auto operator<=>(const Candidate&) const = default;
+        };
+
+        static constexpr std::size_t leafSize = 8;
+
+        std::int64_t distanceTo(std::size_t, Point) const noexcept;
+        std::int64_t splitOffset(std::size_t, std::size_t, Point) const noexcept;
+        void nearest(std::size_t, std::size_t, std::size_t, Point, Candidate&) const;
+        void nearest(std::size_t, std::size_t, std::size_t, Point, std::size_t,
+                     std::vector<Candidate>&) const;
+        void within(std::size_t, std::size_t, std::size_t, Point, std::int64_t,
+                    std::vector<PointId>&) const;
+
+        std::vector<int> xs_;
+        std::vector<int> ys_;
+        std::vector<PointId> ids_;
+    };
+
+    /// Parses the "@x,y" coordinate syntax used by queries to reference an arbitrary location.
+    bool parseCoordinates(std::string_view, Point&) noexcept;
+
+}  // namespace citymap
\ No newline at end of file
@@ -0,0 +1,41 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+using namespace citymap;
+
+ThreadPool::ThreadPool(std::size_t threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    workers_.reserve(threads);
+    for (std::size_t i = 0; i < threads; i++)
+        workers_.emplace_back(&ThreadPool::work, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::scoped_lock lock(mutex_);
+        stop_ = true;
+    }
+    ready_.notify_all();
+    for (auto& worker : workers_)
+        worker.join();
+}
+
+std::size_t ThreadPool::size() const noexcept {
+    return workers_.size();
+}
+
+// queued tasks are drained before the workers exit
+void ThreadPool::work() {
+    while (true) {
+        std::move_only_function<void()> task;
+        {
+            std::unique_lock lock(mutex_);
+            ready_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+            if (tasks_.empty()) return;
+            task = std::move(tasks_.front());
+            tasks_.pop();
+        }
+        task();
+    }
+}
\ No newline at end of file
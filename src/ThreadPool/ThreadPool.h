@@ -0,0 +1,49 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace citymap
+{
+
+    class ThreadPool {
+    public:
+        explicit ThreadPool(std::size_t = 0);
+        ThreadPool(const ThreadPool&) = delete;
+        ~ThreadPool();
+
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        template<typename F>
+        std::future<std::invoke_result_t<F>> submit(F&& func) {
+            std::packaged_task<std::invoke_result_t<F>()> task(std::forward<F>(func));
+            auto future = task.get_future();
+            {
+                std::scoped_lock lock(mutex_);
+                tasks_.emplace(std::move(task));
+            }
+            ready_.notify_one();
+            return future;
+        }
+
+        std::size_t size() const noexcept;
+
+    private:
+        void work();
+
+        std::mutex mutex_;
+        std::condition_variable ready_;
+        std::queue<std::move_only_function<void()>> tasks_;
+        std::vector<std::thread> workers_;
+        bool stop_ {};
+    };
+
+}  // namespace citymap
\ No newline at end of file
@@ -0,0 +1,216 @@
+#include "Tracer.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <iomanip>
+
+using namespace citymap;
+
+static std::string escapeJson(std::string_view str) {
+    std::string out;
+    out.reserve(str.size());
+    for (char c : str) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    constexpr char hex[] = "0123456789abcdef";
+                    out += "\\u00";
+                    out += hex[(c >> 4) & 0xf];
+                    out += hex[c & 0xf];
+                }
+                else
+                    out += c;
+        }
+    }
+    return out;
+}
+
+static constexpr std::size_t indexOf(PathType type) noexcept {
+    return static_cast<std::size_t>(type);
+}
+
+// LatencyHistogram
+
+void LatencyHistogram::record(std::uint64_t ns) noexcept {
+    buckets_[bucketOf(ns)]++;
+    count_++;
+    sum_ += ns;
+    max_ = std::max(max_, ns);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) noexcept {
+    for (std::size_t i = 0; i < bucketCount; i++)
+        buckets_[i] += other.buckets_[i];
+    count_ += other.count_;
+    sum_ += other.sum_;
+    max_ = std::max(max_, other.max_);
+}
+
+std::uint64_t LatencyHistogram::percentile(double q) const noexcept {
+    if (empty()) return 0;
+    auto rank = static_cast<std::uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * count_));
+    rank      = std::max<std::uint64_t>(rank, 1);
+
+    std::uint64_t seen {};
+    for (std::size_t i = 0; i < bucketCount; i++) {
+        seen += buckets_[i];
+        if (seen >= rank) return std::min(upperBoundOf(i), max_);
+    }
+    return max_;
+}
+
+std::uint64_t LatencyHistogram::max() const noexcept {
+    return max_;
+}
+
+std::uint64_t LatencyHistogram::count() const noexcept {
+    return count_;
+}
+
+double LatencyHistogram::mean() const noexcept {
+    return empty() ? 0.0 : static_cast<double>(sum_) / count_;
+}
+
+bool LatencyHistogram::empty() const noexcept {
+    return count_ == 0;
+}
+
+// values below subCount get exact buckets, above that every power of two
+// is split into subCount linear sub-buckets
+std::size_t LatencyHistogram::bucketOf(std::uint64_t ns) noexcept {
+    if (ns < subCount) return ns;
+    std::size_t shift = std::bit_width(ns) - 1 - subBits;
+    return (shift + 1) * subCount + ((ns >> shift) - subCount);
+}
+
+std::uint64_t LatencyHistogram::upperBoundOf(std::size_t bucket) noexcept {
+    if (bucket < subCount) return bucket;
+    std::size_t shift   = bucket / subCount - 1;
+    std::uint64_t lower = (bucket % subCount + subCount) << shift;
+    return lower + ((std::uint64_t {1} << shift) - 1);
+}
+
+// Tracer::Span
+
+Tracer::Span::Span(Tracer& tracer, std::string_view name, std::string_view category)
+    : tracer_(tracer), name_(name), category_(category), begin_(Clock::now()) {}
+
+// the tracer is checked on destruction, so a span opened before tracing
+// was enabled (e.g. around cli parsing) is still recorded
+Tracer::Span::~Span() {
+    tracer_.record(name_, category_, begin_, Clock::now());
+}
+
+// Tracer
+
+Tracer::Tracer()
+    : epoch_(Clock::now()) {}
+
+void Tracer::enable(bool state) noexcept {
+    enabled_ = state;
+}
+
+bool Tracer::enabled() const noexcept {
+    return enabled_;
+}
+
+Tracer::Span Tracer::span(std::string_view name, std::string_view category) {
+    return Span(*this, name, category);
+}
+
+void Tracer::record(std::string_view name, std::string_view category, TimePoint begin,
+                    TimePoint end, std::string_view detail) {
+    if (!enabled_) return;
+    using std::chrono::duration_cast;
+    using std::chrono::nanoseconds;
+
+    std::scoped_lock lock(mutex_);
+    events_.emplace_back(std::string(name), std::string(category), std::string(detail),
+                         duration_cast<nanoseconds>(begin - epoch_).count(),
+                         duration_cast<nanoseconds>(end - begin).count(), threadIndex());
+}
+
+void Tracer::recordQuery(PathType type, TimePoint begin, TimePoint end, std::string_view detail) {
+    if (!enabled_) return;
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+
+    {
+        std::scoped_lock lock(mutex_);
+        latency_[indexOf(type)].record(static_cast<std::uint64_t>(ns));
+    }
+    record(type == PathType::Car ? "Car route" : "Pedestrian route", "query", begin, end, detail);
+}
+
+const LatencyHistogram& Tracer::latency(PathType type) const noexcept {
+    return latency_[indexOf(type)];
+}
+
+void Tracer::summary(std::ostream& out) const {
+    std::scoped_lock lock(mutex_);
+    auto flags = out.flags();
+    out << std::fixed;
+
+    out << "Phase wall time [ms]:\n";
+    for (auto& ev : events_)
+        if (ev.category == "phase")
+            out << "  " << std::left << std::setw(16) << ev.name << std::right << std::setw(12)
+                << std::setprecision(3) << ev.dur / 1e6 << '\n';
+
+    out << "Query latency [us]:\n  " << std::setw(16) << "" << std::setw(8) << "count";
+    for (auto col : {"mean", "p50", "p90", "p99", "max"})
+        out << std::setw(10) << col;
+    out << '\n';
+
+    for (auto type : {PathType::Car, PathType::Pedestrian}) {
+        auto& h = latency_[indexOf(type)];
+        if (h.empty()) continue;
+        out << "  " << std::left << std::setw(16) << (type == PathType::Car ? "Car" : "Pedestrian")
+            << std::right << std::setw(8) << h.count() << std::setprecision(1);
+        for (double ns : {h.mean(), static_cast<double>(h.percentile(0.5)),
+                          static_cast<double>(h.percentile(0.9)),
+                          static_cast<double>(h.percentile(0.99)), static_cast<double>(h.max())})
+            out << std::setw(10) << ns / 1000.0;
+        out << '\n';
+    }
+    out.flags(flags);
+}
+
+// Chrome trace event format (JSON object form), readable by chrome://tracing and Perfetto
+void Tracer::writeChromeTrace(std::ostream& out) const {
+    std::scoped_lock lock(mutex_);
+    auto flags = out.flags();
+    out << std::fixed << std::setprecision(3);
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << R"({"name":"process_name","ph":"M","pid":1,"tid":0,"args":{"name":"citymap"}})";
+    for (auto& [id, tid] : threads_) {
+        out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+            << ",\"args\":{\"name\":\"";
+        if (tid == 0)
+            out << "main";
+        else
+            out << "worker " << tid;
+        out << "\"}}";
+    }
+
+    for (auto& ev : events_) {
+        out << ",\n{\"name\":\"" << escapeJson(ev.name) << "\",\"cat\":\""
+            << escapeJson(ev.category) << "\",\"ph\":\"X\",\"ts\":" << ev.ts / 1000.0
+            << ",\"dur\":" << ev.dur / 1000.0 << ",\"pid\":1,\"tid\":" << ev.tid;
+        if (!ev.detail.empty())
+            out << ",\"args\":{\"detail\":\"" << escapeJson(ev.detail) << "\"}";
+        out << '}';
+    }
+    out << "\n]}\n";
+    out.flags(flags);
+}
+
+// must be called with the mutex held
+std::size_t Tracer::threadIndex() {
+    return threads_.try_emplace(std::this_thread::get_id(), threads_.size()).first->second;
+}
\ No newline at end of file
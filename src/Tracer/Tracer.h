@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Path.h"
+
+namespace citymap
+{
+
+    /// Log-linear latency histogram (nanosecond samples, ~6% relative bucket error).
+    class LatencyHistogram {
+    public:
+        LatencyHistogram()  = default;
+        ~LatencyHistogram() = default;
+
+        void record(std::uint64_t) noexcept;
+        void merge(const LatencyHistogram&) noexcept;
+        std::uint64_t percentile(double) const noexcept;
+        std::uint64_t max() const noexcept;
+        std::uint64_t count() const noexcept;
+        double mean() const noexcept;
+        bool empty() const noexcept;
+
+    private:
+        static constexpr std::size_t subBits     = 4;
+        static constexpr std::size_t subCount    = 1 << subBits;
+        static constexpr std::size_t bucketCount = (64 - subBits + 1) * subCount;
+
+        static std::size_t bucketOf(std::uint64_t) noexcept;
+        static std::uint64_t upperBoundOf(std::size_t) noexcept;
+
+        std::array<std::uint64_t, bucketCount> buckets_ {};
+        std::uint64_t count_ {};
+        std::uint64_t sum_ {};
+        std::uint64_t max_ {};
+    };
+
+    class Tracer {
+    public:
+        using Clock     = std::chrono::steady_clock;
+        using TimePoint = Clock::time_point;
+
+        /// Records the time between its construction and destruction as a complete event.
+        class Span {
+        public:
+            Span(Tracer&, std::string_view, std::string_view);
+            Span(const Span&) = delete;
+            ~Span();
+
+            Span& operator=(const Span&) = delete;
+
+        private:
+            Tracer& tracer_;
+            std::string_view name_;
+            std::string_view category_;
+            TimePoint begin_;
+        };
+
+        Tracer();
+        ~Tracer() = default;
+
+        void enable(bool = true) noexcept;
+        bool enabled() const noexcept;
+        Span span(std::string_view, std::string_view = "phase");
+        void record(std::string_view, std::string_view, TimePoint, TimePoint,
+                    std::string_view = {});
+        void recordQuery(PathType, TimePoint, TimePoint, std::string_view = {});
+        const LatencyHistogram& latency(PathType) const noexcept;
+        void summary(std::ostream&) const;
+        void writeChromeTrace(std::ostream&) const;
+
+    private:
+        struct Event {
+            std::string name;
+            std::string category;
+            std::string detail;
+            std::int64_t ts;   // ns since epoch_
+            std::int64_t dur;  // ns
+            std::size_t tid;
+        };
+
+        std::size_t threadIndex();
+
+        bool enabled_ {};
+        TimePoint epoch_;
+        mutable std::mutex mutex_;
+        std::vector<Event> events_;
+        std::unordered_map<std::thread::id, std::size_t> threads_;
+        std::array<LatencyHistogram, 2> latency_;
+    };
+
+}  // namespace citymap
\ No newline at end of file